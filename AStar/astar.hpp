@@ -19,20 +19,21 @@ struct AStar {
                                               const Node& goal,
                                               NeighFn neighbors,
                                               HeurFn h,
-                                              double eps = 1e-12) {
+                                              double eps = 1e-12,
+                                              size_t* expanded = nullptr) {
     struct Item { double f; Node n; };
     struct MinCmp { bool operator()(const Item& a, const Item& b) const { return a.f > b.f; } };
 
     std::priority_queue<Item, std::vector<Item>, MinCmp> open;
     std::unordered_map<Node,double,Hash,Eq> g;
-    std::unordered_map<Node,Node,  Hase,Eq> came;
-
+    std::unordered_map<Node,Node,  Hash,Eq> came;
 
     auto h0 = h(start, goal);
     if (h0 < 0) h0 = 0;
 
     g[start] = 0.0;
     open.push({h0, start});
+    if (expanded) *expanded = 0;
 
     auto reconstruct = [&](const Node& at){
       std::vector<Node> path; path.push_back(at);
@@ -57,6 +58,7 @@ struct AStar {
       if (itg == g.end()) continue;
       double cur_best_f = itg->second + h(cur, goal);
       if (top.f > cur_best_f + eps) continue;
+      if (expanded) ++*expanded;
 
       const auto& nbrs = neighbors(cur);
       for (const auto& pr : nbrs) {
@@ -0,0 +1,143 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_set>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include "graph.hpp"
+
+// Dense grid view of an edge-list graph whose nodes are "x,y" cells.
+//
+// A graph qualifies when every edge joins 4- or 8-adjacent cells, all
+// straight edges share one weight, all diagonal edges share another, and the
+// edge set is exactly the one implied by the free cells: every straight step
+// between two free cells, plus every diagonal step whose two orthogonal
+// cells are also free (no corner cutting). Anything else is left to AStar::run.
+struct GridMap {
+  using Cell = int;
+
+  int x0 = 0, y0 = 0;          // coordinates of cell 0
+  int width = 0, height = 0;
+  bool diagonal = false;       // 8-connected
+  double straight_cost = 1.0;
+  double diagonal_cost = std::sqrt(2.0);
+  std::vector<unsigned char> open;
+
+  Cell cell(int x, int y) const { return y * width + x; }
+  int cx(Cell c) const { return c % width; }
+  int cy(Cell c) const { return c / width; }
+
+  bool passable(int x, int y) const {
+    return x >= 0 && y >= 0 && x < width && y < height && open[y * width + x];
+  }
+  bool canStep(int x, int y, int dx, int dy) const {
+    if (!passable(x + dx, y + dy)) return false;
+    if (dx && dy) return diagonal && passable(x + dx, y) && passable(x, y + dy);
+    return true;
+  }
+
+  // Cost of a straight or diagonal run between two cells; also an admissible
+  // heuristic (octile / manhattan) for arbitrary pairs.
+  double distance(Cell a, Cell b) const {
+    int dx = std::abs(cx(a) - cx(b)), dy = std::abs(cy(a) - cy(b));
+    if (!diagonal) return straight_cost * (dx + dy);
+    int lo = std::min(dx, dy), hi = std::max(dx, dy);
+    return diagonal_cost * lo + straight_cost * (hi - lo);
+  }
+
+  std::string name(Cell c) const {
+    return std::to_string(cx(c) + x0) + "," + std::to_string(cy(c) + y0);
+  }
+  std::optional<Cell> find(const std::string& node) const;
+};
+
+namespace grid_detail {
+inline bool parse_cell(const std::string& s, int& x, int& y) {
+  auto pos = s.find(',');
+  if (pos == std::string::npos) return false;
+  try {
+    size_t nx = 0, ny = 0;
+    x = std::stoi(s.substr(0, pos), &nx);
+    y = std::stoi(s.substr(pos + 1), &ny);
+    if (nx != pos || ny != s.size() - pos - 1) return false;
+  } catch (...) { return false; }
+  // Only canonical spellings, so cell names round-trip through GridMap::name.
+  return s == std::to_string(x) + "," + std::to_string(y);
+}
+}  // namespace grid_detail
+
+inline std::optional<GridMap::Cell> GridMap::find(const std::string& node) const {
+  int x, y;
+  if (!grid_detail::parse_cell(node, x, y)) return std::nullopt;
+  x -= x0; y -= y0;
+  if (!passable(x, y)) return std::nullopt;
+  return cell(x, y);
+}
+
+inline std::optional<GridMap> grid_from_graph(const Graph& G, long long max_cells = 1LL << 26) {
+  using grid_detail::parse_cell;
+  struct Edge { int ux, uy, vx, vy; double w; };
+  std::vector<Edge> edges;
+  int minx = INT_MAX, miny = INT_MAX, maxx = INT_MIN, maxy = INT_MIN;
+  auto extend = [&](int x, int y) {
+    minx = std::min(minx, x); maxx = std::max(maxx, x);
+    miny = std::min(miny, y); maxy = std::max(maxy, y);
+  };
+
+  double ws = -1, wd = -1;
+  for (const auto& [u, nbrs] : G.adj) {
+    int ux, uy;
+    if (!parse_cell(u, ux, uy)) return std::nullopt;
+    extend(ux, uy);
+    for (const auto& [v, w] : nbrs) {
+      int vx, vy;
+      if (!parse_cell(v, vx, vy)) return std::nullopt;
+      int dx = std::abs(vx - ux), dy = std::abs(vy - uy);
+      if (dx > 1 || dy > 1 || (dx == 0 && dy == 0) || !(w > 0)) return std::nullopt;
+      double& ref = (dx && dy) ? wd : ws;
+      if (ref < 0) ref = w;
+      else if (ref != w) return std::nullopt;
+      extend(vx, vy);
+      edges.push_back({ux, uy, vx, vy, w});
+    }
+  }
+  if (edges.empty() || ws < 0) return std::nullopt;
+  if ((long long)(maxx - minx + 1) * (maxy - miny + 1) > max_cells) return std::nullopt;
+
+  GridMap m;
+  m.x0 = minx; m.y0 = miny;
+  m.width = maxx - minx + 1; m.height = maxy - miny + 1;
+  m.diagonal = wd > 0;
+  m.straight_cost = ws;
+  if (m.diagonal) {
+    // Pruning relies on a diagonal never being beaten by its two legs.
+    if (wd < ws || wd > 2 * ws) return std::nullopt;
+    m.diagonal_cost = wd;
+  }
+  m.open.assign((size_t)m.width * m.height, 0);
+  for (const auto& e : edges) {
+    m.open[m.cell(e.ux - minx, e.uy - miny)] = 1;
+    m.open[m.cell(e.vx - minx, e.vy - miny)] = 1;
+  }
+
+  // Every listed edge must be implied by the free cells, and no implied edge
+  // may be missing. Duplicate lines collapse onto the same key.
+  std::unordered_set<long long> seen;
+  for (const auto& e : edges) {
+    int x = e.ux - minx, y = e.uy - miny, dx = e.vx - e.ux, dy = e.vy - e.uy;
+    if (!m.canStep(x, y, dx, dy)) return std::nullopt;
+    seen.insert((long long)m.cell(x, y) * 9 + (dy + 1) * 3 + (dx + 1));
+  }
+  size_t implied = 0;
+  for (int y = 0; y < m.height; ++y)
+    for (int x = 0; x < m.width; ++x) {
+      if (!m.open[m.cell(x, y)]) continue;
+      for (int dy = -1; dy <= 1; ++dy)
+        for (int dx = -1; dx <= 1; ++dx)
+          if ((dx || dy) && m.canStep(x, y, dx, dy)) ++implied;
+    }
+  if (implied != seen.size()) return std::nullopt;
+  return m;
+}
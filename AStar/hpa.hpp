@@ -0,0 +1,209 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <optional>
+#include <algorithm>
+#include <limits>
+#include "astar.hpp"
+#include "grid_map.hpp"
+
+// Hierarchical path abstraction (HPA*, Botea et al.) on uniform-cost grids.
+//
+// The map is cut into cluster x cluster blocks. Each maximal run of open
+// cell pairs facing each other across a block border is an entrance with one
+// transition in its middle, or one at each end if it is 6 or more wide. The
+// transition cells are the nodes of an abstract graph: the two cells of a
+// transition are joined by one straight step, and the nodes of a block by
+// their shortest distance inside it, found once when the HPA is built.
+//
+// A query links start and goal to the nodes of their blocks, runs
+// AStar::run on the abstract graph, and refines each abstract edge into
+// cells with a search confined to one block. The result is a valid path
+// whose cost is that of the abstract route, usually within a few percent of
+// optimal but not guaranteed optimal. The work is a few blocks at each end
+// plus a search over a graph far smaller than the grid, instead of a search
+// over everything within the optimal cost of the start.
+//
+// run()'s `expanded` counts abstract nodes plus the cells settled by the
+// searches inside blocks (linking start and goal, refining), so it compares
+// with the other engines; the one-off build work is buildExpanded().
+
+class HPA {
+public:
+  using Cell = GridMap::Cell;
+
+  struct LevelStats {
+    int cluster_size;  // cells per block side; 1 for the grid itself
+    size_t nodes, edges, bytes;
+  };
+
+  explicit HPA(const GridMap& m, int cluster = 16) : m_(m), size_(std::max(cluster, 2)) {
+    cols_ = (m.width + size_ - 1) / size_;
+    rows_ = (m.height + size_ - 1) / size_;
+    for (int x = size_; x < m.width; x += size_)
+      for (int y = 0; y < m.height; y += size_)
+        add_entrances(x - 1, y, x, y, 0, 1, std::min(size_, m.height - y));
+    for (int y = size_; y < m.height; y += size_)
+      for (int x = 0; x < m.width; x += size_)
+        add_entrances(x, y - 1, x, y, 1, 0, std::min(size_, m.width - x));
+
+    members_.assign((size_t)cols_ * rows_, {});
+    for (int n = 0; n < (int)nodes_.size(); ++n) members_[block(nodes_[n].cell)].push_back(n);
+    adj_.assign(nodes_.size(), {});
+    std::vector<double> dist;
+    for (int n = 0; n < (int)nodes_.size(); ++n) {
+      const Node& u = nodes_[n];
+      adj_[n].push_back({u.partner, m.straight_cost});
+      build_expanded_ += in_block(u.cell, -1, dist, nullptr);
+      for (int k : members_[block(u.cell)]) {
+        double d = dist[local(nodes_[k].cell)];
+        if (k != n && d < kInf) adj_[n].push_back({k, d});
+      }
+    }
+  }
+
+  // Cells settled while building the abstract graph.
+  size_t buildExpanded() const { return build_expanded_; }
+
+  // Level 0 is the grid, level 1 the abstract graph.
+  LevelStats stats(int level) const {
+    if (level == 0)
+      return {1, (size_t)std::count(m_.open.begin(), m_.open.end(), 1), 0,
+              sizeof(GridMap) + m_.open.capacity()};
+    size_t edges = 0, bytes = sizeof(HPA) + nodes_.capacity() * sizeof(Node)
+                                + adj_.capacity() * sizeof(Adj)
+                                + members_.capacity() * sizeof(std::vector<int>);
+    for (const auto& a : adj_) { edges += a.size(); bytes += a.capacity() * sizeof(a[0]); }
+    for (const auto& b : members_) bytes += b.capacity() * sizeof(int);
+    return {size_, nodes_.size(), edges, bytes};
+  }
+
+  std::optional<std::vector<Cell>> run(Cell start, Cell goal, size_t* expanded = nullptr) const {
+    if (expanded) *expanded = 0;
+    if (start == goal) return std::vector<Cell>{start};
+    size_t cells = 0;
+
+    // Temporary nodes for start and goal; the goal's block members get an
+    // extra edge to it, in copies so the built graph stays untouched.
+    const int S = (int)nodes_.size(), T = S + 1;
+    std::unordered_map<int, Adj> patched;
+    std::vector<double> dist;
+    cells += in_block(goal, -1, dist, nullptr);
+    for (int k : members_[block(goal)]) {
+      double d = dist[local(nodes_[k].cell)];
+      if (d < kInf) (patched[k] = adj_[k]).push_back({T, d});
+    }
+    Adj& from = patched[S];
+    cells += in_block(start, -1, dist, nullptr);
+    for (int k : members_[block(start)]) {
+      double d = dist[local(nodes_[k].cell)];
+      if (d < kInf) from.push_back({k, d});
+    }
+    if (block(start) == block(goal) && dist[local(goal)] < kInf) from.push_back({T, dist[local(goal)]});
+    patched[T];
+
+    auto cell_of = [&](int n) { return n == S ? start : n == T ? goal : nodes_[n].cell; };
+    AStar<int>::NeighFn neigh = [&](const int& n) -> const Adj& {
+      auto it = patched.find(n);
+      return it != patched.end() ? it->second : adj_[n];
+    };
+    AStar<int>::HeurFn h = [&](const int& a, const int& b) {
+      return m_.distance(cell_of(a), cell_of(b));
+    };
+    auto route = AStar<int>::run(S, T, neigh, h, 1e-12, expanded);
+    if (expanded) *expanded += cells;
+    if (!route) return std::nullopt;
+
+    cells = 0;
+    std::vector<Cell> path = {start};
+    std::vector<int> parent;
+    for (size_t i = 1; i < route->size(); ++i) {
+      int u = (*route)[i - 1], v = (*route)[i];
+      Cell a = cell_of(u), b = cell_of(v);
+      if (u < S && nodes_[u].partner == v) { path.push_back(b); continue; }
+      cells += in_block(a, local(b), dist, &parent);
+      size_t at = path.size();
+      for (int l = local(b); l != local(a); l = parent[l]) path.push_back(global(a, l));
+      std::reverse(path.begin() + at, path.end());
+    }
+    if (expanded) *expanded += cells;
+    return path;
+  }
+
+private:
+  using Adj = AStar<int>::NeighborList;
+  static constexpr double kInf = std::numeric_limits<double>::infinity();
+  static constexpr int kWideEntrance = 6;
+
+  struct Node { Cell cell; int partner; };
+
+  const GridMap& m_;
+  int size_, cols_, rows_;
+  std::vector<Node> nodes_;
+  std::vector<Adj> adj_;                   // partner first, then the block
+  std::vector<std::vector<int>> members_;  // block -> its nodes
+  size_t build_expanded_ = 0;
+
+  int block(Cell c) const { return (m_.cy(c) / size_) * cols_ + m_.cx(c) / size_; }
+  // Cell c's index within its block; global() maps back, given any cell of it.
+  int local(Cell c) const { return (m_.cy(c) % size_) * size_ + m_.cx(c) % size_; }
+  Cell global(Cell any, int l) const {
+    return m_.cell(m_.cx(any) / size_ * size_ + l % size_, m_.cy(any) / size_ * size_ + l / size_);
+  }
+
+  void add_entrances(int ax, int ay, int bx, int by, int dx, int dy, int len) {
+    int run = 0;
+    for (int i = 0; i <= len; ++i) {
+      if (i < len && m_.passable(ax + i * dx, ay + i * dy) && m_.passable(bx + i * dx, by + i * dy)) {
+        ++run;
+        continue;
+      }
+      auto add = [&](int k) {
+        int n = (int)nodes_.size();
+        nodes_.push_back({m_.cell(ax + k * dx, ay + k * dy), n + 1});
+        nodes_.push_back({m_.cell(bx + k * dx, by + k * dy), n});
+      };
+      if (run >= kWideEntrance) { add(i - run); add(i - 1); }
+      else if (run) add(i - run + run / 2);
+      run = 0;
+    }
+  }
+
+  // Dijkstra from `from` without leaving its block; dist (and parent, if
+  // given) are indexed by local(). Stops once local cell `stop` is settled.
+  // Returns the number of cells settled.
+  size_t in_block(Cell from, int stop, std::vector<double>& dist, std::vector<int>* parent) const {
+    const int bx = m_.cx(from) / size_ * size_, by = m_.cy(from) / size_ * size_;
+    const int bw = std::min(size_, m_.width - bx), bh = std::min(size_, m_.height - by);
+    dist.assign((size_t)size_ * size_, kInf);
+    if (parent) parent->assign(dist.size(), -1);
+    struct Item { double d; int l; };
+    struct MinCmp { bool operator()(const Item& a, const Item& b) const { return a.d > b.d; } };
+    std::priority_queue<Item, std::vector<Item>, MinCmp> open;
+    dist[local(from)] = 0;
+    open.push({0, local(from)});
+    size_t settled = 0;
+    while (!open.empty()) {
+      Item top = open.top(); open.pop();
+      if (top.d > dist[top.l]) continue;
+      ++settled;
+      if (top.l == stop) return settled;
+      int x = bx + top.l % size_, y = by + top.l / size_;
+      for (int dy = -1; dy <= 1; ++dy)
+        for (int dx = -1; dx <= 1; ++dx) {
+          int nx = x + dx, ny = y + dy;
+          if ((!dx && !dy) || nx < bx || ny < by || nx >= bx + bw || ny >= by + bh) continue;
+          if (!m_.canStep(x, y, dx, dy)) continue;
+          int l = (ny - by) * size_ + (nx - bx);
+          double nd = top.d + (dx && dy ? m_.diagonal_cost : m_.straight_cost);
+          if (nd < dist[l]) {
+            dist[l] = nd;
+            if (parent) (*parent)[l] = top.l;
+            open.push({nd, l});
+          }
+        }
+    }
+    return settled;
+  }
+};
@@ -0,0 +1,260 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <optional>
+#include <algorithm>
+#include <limits>
+#include "grid_map.hpp"
+
+// Jump Point Search on uniform-cost grids (Harabor & Grastien; no corner
+// cutting). Instead of expanding every cell, A* only expands "jump points":
+// cells where an optimal path may have to turn. On open maps this removes
+// almost all of the symmetric paths plain A* explores.
+//
+//   8-connected: straight runs stop at forced neighbours, diagonal runs stop
+//                where a straight sub-run finds something.
+//   4-connected: horizontal runs stop at forced neighbours, vertical runs stop
+//                where a horizontal sub-run finds something.
+//
+// JPS    - jump points are found online by scanning.
+// JPSPlus - the scans are precomputed per cell and direction (JPS+, Rabin),
+//           so a query only does table lookups plus a goal-bounding check.
+//
+// Both return the full cell-by-cell path, so costs match AStar::run.
+
+namespace jps_detail {
+using Cell = GridMap::Cell;
+struct Dir { int dx, dy; };
+
+inline int sgn(int v) { return (v > 0) - (v < 0); }
+
+// Straight move into (x,y): some side cell is only reachable through (x,y).
+inline bool forced(const GridMap& m, int x, int y, int dx, int dy) {
+  for (int s = -1; s <= 1; s += 2) {
+    if (dx && m.passable(x, y + s) && !m.passable(x - dx, y + s)) return true;
+    if (dy && m.passable(x + s, y) && !m.passable(x + s, y - dy)) return true;
+  }
+  return false;
+}
+
+// Directions worth scanning from (x,y) after arriving along (dx,dy): the
+// natural ones plus any forced by nearby obstacles. (0,0) means the start.
+inline void directions(const GridMap& m, int x, int y, int dx, int dy, std::vector<Dir>& out) {
+  out.clear();
+  if (!dx && !dy) {
+    out.insert(out.end(), {{1,0},{-1,0},{0,1},{0,-1}});
+    if (m.diagonal) out.insert(out.end(), {{1,1},{-1,1},{1,-1},{-1,-1}});
+    return;
+  }
+  if (m.diagonal && dx && dy) {
+    out.insert(out.end(), {{dx,0},{0,dy},{dx,dy}});
+    return;
+  }
+  if (!m.diagonal && dy) {
+    out.insert(out.end(), {{0,dy},{1,0},{-1,0}});
+    return;
+  }
+  out.push_back({dx, dy});
+  for (int s = -1; s <= 1; s += 2) {
+    if (dx && m.passable(x, y + s) && !m.passable(x - dx, y + s)) {
+      out.push_back({0, s});
+      if (m.diagonal) out.push_back({dx, s});
+    }
+    if (dy && m.passable(x + s, y) && !m.passable(x + s, y - dy)) {
+      out.push_back({s, 0});
+      out.push_back({s, dy});
+    }
+  }
+}
+
+// A* over jump points. succ(cell, dx, dy, out) appends the jump points
+// reachable from `cell` when it was entered along (dx,dy).
+template <typename SuccFn>
+std::optional<std::vector<Cell>> search(const GridMap& m, Cell start, Cell goal,
+                                        SuccFn succ, size_t* expanded) {
+  struct Rec { double g; Cell parent; bool closed; };
+  struct Item { double f, g; Cell c; };
+  struct MinCmp {
+    bool operator()(const Item& a, const Item& b) const {
+      return a.f > b.f || (a.f == b.f && a.g < b.g);
+    }
+  };
+  const double eps = 1e-12;
+
+  std::priority_queue<Item, std::vector<Item>, MinCmp> open;
+  std::unordered_map<Cell, Rec> rec;
+  rec[start] = {0.0, -1, false};
+  open.push({m.distance(start, goal), 0.0, start});
+  if (expanded) *expanded = 0;
+
+  std::vector<Cell> nbrs;
+  while (!open.empty()) {
+    Item top = open.top(); open.pop();
+    Rec& r = rec[top.c];
+    if (r.closed) continue;
+    r.closed = true;
+    if (expanded) ++*expanded;
+
+    if (top.c == goal) {
+      std::vector<Cell> jumps;
+      for (Cell c = goal; c >= 0; c = rec[c].parent) jumps.push_back(c);
+      std::reverse(jumps.begin(), jumps.end());
+      std::vector<Cell> path{jumps[0]};
+      for (size_t i = 1; i < jumps.size(); ++i) {
+        int x = m.cx(jumps[i-1]), y = m.cy(jumps[i-1]);
+        int tx = m.cx(jumps[i]), ty = m.cy(jumps[i]);
+        int dx = sgn(tx - x), dy = sgn(ty - y);
+        while (x != tx || y != ty) { x += dx; y += dy; path.push_back(m.cell(x, y)); }
+      }
+      return path;
+    }
+
+    int dx = 0, dy = 0;
+    if (r.parent >= 0) {
+      dx = sgn(m.cx(top.c) - m.cx(r.parent));
+      dy = sgn(m.cy(top.c) - m.cy(r.parent));
+    }
+    double g = r.g;
+    nbrs.clear();
+    succ(top.c, dx, dy, nbrs);
+    for (Cell s : nbrs) {
+      double ng = g + m.distance(top.c, s);
+      auto it = rec.find(s);
+      if (it != rec.end() && (it->second.closed || ng + eps >= it->second.g)) continue;
+      rec[s] = {ng, top.c, false};
+      open.push({ng + m.distance(s, goal), ng, s});
+    }
+  }
+  return std::nullopt;
+}
+}  // namespace jps_detail
+
+struct JPS {
+  using Cell = GridMap::Cell;
+
+  static std::optional<std::vector<Cell>> run(const GridMap& m, Cell start, Cell goal,
+                                              size_t* expanded = nullptr) {
+    std::vector<jps_detail::Dir> dirs;
+    auto succ = [&](Cell c, int dx, int dy, std::vector<Cell>& out) {
+      int x = m.cx(c), y = m.cy(c);
+      jps_detail::directions(m, x, y, dx, dy, dirs);
+      for (auto d : dirs) {
+        Cell j = jump(m, x, y, d.dx, d.dy, goal);
+        if (j >= 0) out.push_back(j);
+      }
+    };
+    return jps_detail::search(m, start, goal, succ, expanded);
+  }
+
+private:
+  static Cell jump(const GridMap& m, int x, int y, int dx, int dy, Cell goal) {
+    for (;;) {
+      if (!m.canStep(x, y, dx, dy)) return -1;
+      x += dx; y += dy;
+      Cell c = m.cell(x, y);
+      if (c == goal) return c;
+      if (m.diagonal && dx && dy) {
+        if (jump(m, x, y, dx, 0, goal) >= 0 || jump(m, x, y, 0, dy, goal) >= 0) return c;
+      } else if (!m.diagonal && dy) {
+        if (jump(m, x, y, 1, 0, goal) >= 0 || jump(m, x, y, -1, 0, goal) >= 0) return c;
+      } else if (jps_detail::forced(m, x, y, dx, dy)) {
+        return c;
+      }
+    }
+  }
+};
+
+class JPSPlus {
+public:
+  using Cell = GridMap::Cell;
+
+  // Precomputes, for every cell and direction, the distance to the next
+  // jump point (> 0) or minus the number of free steps before a wall (<= 0).
+  explicit JPSPlus(const GridMap& m) : m_(m), dist_(m.open.size() * 8, 0) {
+    static const jps_detail::Dir kStraight[] = {{1,0},{-1,0},{0,1},{0,-1}};
+    static const jps_detail::Dir kDiagonal[] = {{1,1},{-1,1},{1,-1},{-1,-1}};
+    for (auto d : kStraight) {
+      // On 4-connected maps vertical runs behave like diagonals do on
+      // 8-connected ones, so they are filled in the second pass.
+      if (!m_.diagonal && d.dy) continue;
+      fill(d, [&](int x, int y) { return jps_detail::forced(m_, x, y, d.dx, d.dy); });
+    }
+    if (m_.diagonal) {
+      for (auto d : kDiagonal)
+        fill(d, [&](int x, int y) {
+          Cell c = m_.cell(x, y);
+          return at(c, d.dx, 0) > 0 || at(c, 0, d.dy) > 0;
+        });
+    } else {
+      for (int dy = -1; dy <= 1; dy += 2)
+        fill({0, dy}, [&](int x, int y) {
+          Cell c = m_.cell(x, y);
+          return at(c, 1, 0) > 0 || at(c, -1, 0) > 0;
+        });
+    }
+  }
+
+  size_t tableBytes() const { return dist_.size() * sizeof(int); }
+
+  std::optional<std::vector<Cell>> run(Cell start, Cell goal, size_t* expanded = nullptr) const {
+    using jps_detail::sgn;
+    const int gx = m_.cx(goal), gy = m_.cy(goal);
+    std::vector<jps_detail::Dir> dirs;
+    auto succ = [&](Cell c, int pdx, int pdy, std::vector<Cell>& out) {
+      int x = m_.cx(c), y = m_.cy(c);
+      int ddx = gx - x, ddy = gy - y;
+      jps_detail::directions(m_, x, y, pdx, pdy, dirs);
+      for (auto d : dirs) {
+        int k = at(c, d.dx, d.dy), reach = std::abs(k);
+        bool composite = m_.diagonal ? (d.dx && d.dy) : (d.dy != 0);
+        if (!composite) {
+          // Goal sitting on the ray, no further than the stop cell.
+          bool on_ray = d.dx ? (ddy == 0 && sgn(ddx) == d.dx) : (ddx == 0 && sgn(ddy) == d.dy);
+          if (on_ray && std::abs(ddx + ddy) <= reach) { out.push_back(goal); continue; }
+        } else if (m_.diagonal) {
+          // Goal in this quadrant: stop where a straight run could reach it.
+          if (sgn(ddx) == d.dx && sgn(ddy) == d.dy) {
+            int steps = std::min(std::abs(ddx), std::abs(ddy));
+            if (steps <= reach) { out.push_back(m_.cell(x + steps * d.dx, y + steps * d.dy)); continue; }
+          }
+        } else if (sgn(ddy) == d.dy && std::abs(ddy) <= reach) {
+          out.push_back(m_.cell(x, gy));
+          continue;
+        }
+        if (k > 0) out.push_back(m_.cell(x + k * d.dx, y + k * d.dy));
+      }
+    };
+    return jps_detail::search(m_, start, goal, succ, expanded);
+  }
+
+private:
+  const GridMap& m_;
+  std::vector<int> dist_;
+
+  static int slot(int dx, int dy) {
+    static const int kSlot[9] = {7, 3, 6, 1, -1, 0, 5, 2, 4};
+    return kSlot[(dy + 1) * 3 + (dx + 1)];
+  }
+  int at(Cell c, int dx, int dy) const { return dist_[(size_t)c * 8 + slot(dx, dy)]; }
+
+  // Sweeps against the direction so each cell's successor is already known.
+  template <typename StopFn>
+  void fill(jps_detail::Dir d, StopFn stops) {
+    const int w = m_.width, h = m_.height;
+    for (int iy = 0; iy < h; ++iy) {
+      int y = d.dy > 0 ? h - 1 - iy : iy;
+      for (int ix = 0; ix < w; ++ix) {
+        int x = d.dx > 0 ? w - 1 - ix : ix;
+        Cell c = m_.cell(x, y);
+        if (!m_.open[c]) continue;
+        int& out = dist_[(size_t)c * 8 + slot(d.dx, d.dy)];
+        if (!m_.canStep(x, y, d.dx, d.dy)) { out = 0; continue; }
+        int nx = x + d.dx, ny = y + d.dy;
+        if (stops(nx, ny)) { out = 1; continue; }
+        int next = at(m_.cell(nx, ny), d.dx, d.dy);
+        out = next > 0 ? next + 1 : next - 1;
+      }
+    }
+  }
+};
@@ -4,6 +4,9 @@
 #include <optional>
 #include "astar.hpp"
 #include "graph.hpp"
+#include "grid_map.hpp"
+#include "jps.hpp"
+#include "hpa.hpp"
 
 using Node = std::string;
 
@@ -30,6 +33,7 @@ static double euclidean(const Node& a, const Node& b) {
 
 int main(int argc, char** argv) {
   std::string graph_path; Node src, dst; bool undirected=false; std::string heur="manhattan";
+  std::string engine="astar"; bool stats=false;
   for (int i=1; i<argc; ++i) {
     std::string arg = argv[i];
     auto need = [&](const char* name){ if (i+1>=argc) { std::cerr << "missing value for " << name << "\n"; std::exit(1);} return std::string(argv[++i]); };
@@ -37,11 +41,14 @@ int main(int argc, char** argv) {
     else if (arg == "--src") src = need("--src");
     else if (arg == "--dst") dst = need("--dst");
     else if (arg == "--heuristic") heur = need("--heuristic");
+    else if (arg == "--engine") engine = need("--engine");
     else if (arg == "--undirected") undirected = true;
+    else if (arg == "--stats") stats = true;
     else { std::cerr << "Unknown arg: " << arg << "\n"; return 1; }
   }
   if (graph_path.empty() || src.empty() || dst.empty()) {
-    std::cerr << "Usage: astar --graph <file> --src <id> --dst <id> [--undirected] [--heuristic none|manhattan|euclidean]\n";
+    std::cerr << "Usage: astar --graph <file> --src <id> --dst <id> [--undirected] [--heuristic none|manhattan|euclidean]\n"
+                 "             [--engine astar|jps|jps+|hpa] [--stats]\n";
     return 1;
   }
 
@@ -59,7 +66,48 @@ int main(int argc, char** argv) {
   else if (heur == "euclidean") h = euclidean;
   else { std::cerr << "Unknown heuristic: " << heur << ". Falling back to none.\n"; }
 
-  auto path = AStar<Node>::run(src, dst, neigh, h);
+  // Grid engines only apply when the graph is a uniform 4/8-connected grid;
+  // they use the octile/manhattan distance regardless of --heuristic. hpa
+  // trades optimality for speed on large maps (see hpa.hpp).
+  std::optional<GridMap> grid;
+  if (engine == "jps" || engine == "jps+" || engine == "hpa") {
+    grid = grid_from_graph(G);
+    if (!grid) { std::cerr << "Graph is not a uniform-cost grid; using astar.\n"; engine = "astar"; }
+  } else if (engine != "astar") {
+    std::cerr << "Unknown engine: " << engine << ". Falling back to astar.\n"; engine = "astar";
+  }
+
+  size_t expanded = 0;
+  std::optional<std::vector<Node>> path;
+  if (engine == "astar") {
+    path = AStar<Node>::run(src, dst, neigh, h, 1e-12, &expanded);
+  } else {
+    auto s = grid->find(src), t = grid->find(dst);
+    if (s && t) {
+      std::optional<std::vector<GridMap::Cell>> cells;
+      if (engine == "jps") cells = JPS::run(*grid, *s, *t, &expanded);
+      else if (engine == "jps+") cells = JPSPlus(*grid).run(*s, *t, &expanded);
+      else {
+        HPA hpa(*grid);
+        cells = hpa.run(*s, *t, &expanded);
+        if (stats) {
+          for (int l = 0; l <= 1; ++l) {
+            auto st = hpa.stats(l);
+            std::cerr << "LEVEL " << l << " cluster " << st.cluster_size << " nodes " << st.nodes
+                      << " edges " << st.edges << " bytes " << st.bytes << "\n";
+          }
+          std::cerr << "BUILD_EXPANDED " << hpa.buildExpanded() << "\n";
+        }
+      }
+      if (cells) {
+        path.emplace();
+        for (auto c : *cells) path->push_back(grid->name(c));
+      }
+    } else if (src == dst) {
+      path = std::vector<Node>{src};
+    }
+  }
+  if (stats) std::cerr << "EXPANDED " << expanded << "\n";
   if (!path) { std::cout << "NO_PATH\n"; return 0; }
 
   double cost = 0.0;
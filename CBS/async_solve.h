@@ -0,0 +1,81 @@
+#pragma once
+#include "solver.h"
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+
+/*
+ * Asynchronous solving
+ *
+ * solveAsync hands a solver to a caller-supplied executor and returns at
+ * once. The handle gives a std::future for the result and can cancel the
+ * solve; progress events (nodes expanded, lower bound, incumbent) arrive on
+ * the executor's thread through the callback, so it must be thread-safe with
+ * respect to the caller. Only anytime solvers (LNSSolver, lns.h) have an
+ * incumbent before the final event. Solvers write nothing to stdout, and each
+ * solve owns its solver, so any number can run side by side.
+ *
+ * An Executor is anything that runs a job eventually, e.g. a thread pool's
+ * post(). newThreadExecutor() runs each job on a detached thread.
+ */
+
+using Executor = std::function<void(std::function<void()>)>;
+
+inline Executor newThreadExecutor() {
+    return [](std::function<void()> job) { std::thread(std::move(job)).detach(); };
+}
+
+struct SolveResult {
+    SolveStatus status;
+    std::vector<Path> paths;  // empty unless isSolved(status)
+    int cost;                 // -1 unless isSolved(status)
+    int nodes_expanded;
+    int nodes_generated;
+};
+
+class SolveHandle {
+public:
+    // Blocks until the solve ends. Rethrows what solve() threw, if anything.
+    SolveResult get() { return result_.get(); }
+    std::future<SolveResult>& future() { return result_; }
+
+    // Safe from any thread, before or during the solve; the result then has
+    // status CANCELLED unless the solve had already finished (or, for an
+    // anytime solver, SOLVED with its best solution). It only asks: the solve
+    // may still be running, and reading the grid and agents, when this
+    // returns, so wait for it with get() or future() before destroying them.
+    void cancel() { solver_->cancel(); }
+
+private:
+    friend SolveHandle solveAsync(std::unique_ptr<MAPFSolver>, const Executor&, int,
+                                  ProgressCallback, int);
+    std::shared_ptr<MAPFSolver> solver_;
+    std::future<SolveResult> result_;
+};
+
+// The handle shares ownership of the solver; the grid and agents it refers
+// to must stay alive until the result is ready.
+inline SolveHandle solveAsync(std::unique_ptr<MAPFSolver> solver, const Executor& executor,
+                              int max_nodes = 100000, ProgressCallback on_progress = {},
+                              int progress_every = 1000) {
+    SolveHandle handle;
+    handle.solver_ = std::move(solver);
+    if (on_progress) handle.solver_->setProgressCallback(std::move(on_progress), progress_every);
+
+    auto promise = std::make_shared<std::promise<SolveResult>>();
+    handle.result_ = promise->get_future();
+    std::shared_ptr<MAPFSolver> s = handle.solver_;
+    executor([s, promise, max_nodes] {
+        try {
+            bool ok = s->solve(max_nodes);
+            promise->set_value({s->getStatus(), ok ? s->getSolution() : std::vector<Path>(),
+                                ok ? s->getSolutionCost() : -1,
+                                s->getNodesExpanded(), s->getNodesGenerated()});
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return handle;
+}
@@ -2,8 +2,15 @@
 #include "common.h"
 #include "grid.h"
 #include "low_level.h"
-#include <queue>
-#include <list>
+#include "incremental_low_level.h"
+#include "conflicts.h"
+#include "reservation_table.h"
+#include "heuristic.h"
+#include "solver.h"
+#include "symmetry.h"
+#include <algorithm>
+#include <deque>
+#include <limits>
 #include <memory>
 
 /*
@@ -19,16 +26,34 @@
  *
  *   LOW LEVEL: Space-Time A* (low_level.h).
  *     - Given constraints for one agent, find shortest path obeying them.
+ *     - Constraints live in a per-agent ConstraintStore (constraint_table.h),
+ *       so a child only rebuilds the table of the agent it replans.
+ *     - Optional incremental mode (incremental_low_level.h): each CT node keeps
+ *       every agent's LPA* search, and a child repairs its parent's search for
+ *       the replanned agent instead of starting over.
  *
- *  This is standard CBS (Sharon et al., 2015). No CBSH (Jiaoyang Li) improvements.
+ *   WINDOWED MODE (setConflictWindow): only conflicts up to timestep w are
+ *   resolved, as in Rolling-Horizon Collision Resolution (Li et al., 2021).
+ *   Paths still run to the goals; lifelong.h executes just their first steps.
+ *
+ *   MEMORY: CT nodes come from a CTNodePool and are recycled after expansion.
+ *   setMemoryBudget caps the bytes held by OPEN, dropping its worst nodes or
+ *   stopping when the cap is reached.
+ *
+ *   SYMMETRY REASONING (setSymmetryReasoning): rectangle and corridor
+ *   conflicts are split with barrier or range constraints (symmetry.h), so a
+ *   child may add several constraints at once. Optimality is kept.
+ *
+ *  Otherwise this is standard CBS (Sharon et al., 2015), without CBSH's
+ *  conflict prioritization or heuristics.
  */
 
 struct CTNode {
     std::vector<Path> paths;            
-    std::vector<Constraint> constraints;
+    ConstraintStore constraints;
+    std::vector<std::shared_ptr<const IncrementalSTAStar>> planners;  // incremental mode only
     int cost;                           
-
-    bool operator>(const CTNode& o) const { return cost > o.cost; }
+    size_t bytes = 0;  // memory charged to this node while it is live
 
     void computeCost() {
         cost = 0;
@@ -37,132 +62,340 @@ struct CTNode {
     }
 };
 
-class CBS {
+/*
+ * CT node pool
+ *
+ * Nodes live in a deque (stable addresses) and go back on a free list once
+ * expanded or dropped. A recycled node keeps its path vectors, so copying the
+ * parent's paths into it reuses their buffers: after warm-up the high level
+ * allocates almost nothing per node. Nodes are owned by plain pointers, with
+ * no reference counting.
+ */
+class CTNodePool {
+public:
+    CTNode* acquire() {
+        if (free_.empty()) {
+            nodes_.emplace_back();
+            return &nodes_.back();
+        }
+        CTNode* n = free_.back();
+        free_.pop_back();
+        return n;
+    }
+
+    // Drops the node's references to shared tables and planners; path
+    // buffers stay for the next user.
+    void release(CTNode* n) {
+        n->constraints.clear();
+        std::fill(n->planners.begin(), n->planners.end(), nullptr);
+        n->bytes = 0;
+        free_.push_back(n);
+    }
+
+    size_t allocated() const { return nodes_.size(); }
+
+private:
+    std::deque<CTNode> nodes_;
+    std::vector<CTNode*> free_;
+};
+
+class CBS : public MAPFSolver {
 public:
+    // What solve() does once live CT nodes exceed the memory budget.
+    enum class MemoryPolicy {
+        // Discard the worst nodes for good: unlike SMA*, dropped subtrees
+        // are never regenerated, so completeness may be lost. Only their
+        // cheapest cost is kept, as the lower bound; a solution costing more
+        // ends with SOLVED_SUBOPTIMAL.
+        DROP_WORST,
+        STOP,        // give up and return false
+    };
+
     CBS(const Grid& grid, const std::vector<Agent>& agents)
-        : grid_(grid), agents_(agents) {}
+        : MAPFSolver(grid, agents) {}
+
+    const char* name() const override { return "CBS"; }
+
+    // Reuse the parent's low-level search when replanning an agent. Costs one
+    // copy of that agent's search state per generated CT node.
+    void setIncrementalLowLevel(bool on) { incremental_ = on; }
+
+    // Ignore conflicts after timestep `window` (< 0: resolve all of them).
+    void setConflictWindow(int window) { window_ = window; }
+
+    // Goal distance tables for the low level. The cache must outlive solve()
+    // and is shared with whoever owns it, e.g. successive lifelong replans.
+    // CBS has no setMapCache of its own: give the cache a MapCache with
+    // HeuristicCache::setStore to persist its tables.
+    void setHeuristicCache(HeuristicCache* cache) { heuristic_cache_ = cache; }
+
+    // Root paths to try before planning: paths[i] is used for agent i if it
+    // runs from its start to its goal in the minimum number of steps
+    // (requires a heuristic cache to check). Typically the unexecuted rest of
+    // the previous replan.
+    void setInitialPaths(std::vector<Path> paths) { initial_paths_ = std::move(paths); }
+
+    // Paths of agents outside this instance that every agent must avoid,
+    // e.g. the fixed agents around an LNS neighborhood. Must outlive solve().
+    // The incremental low level doesn't support them and is skipped.
+    void setReservations(const ReservationTable* reserved) { reserved_ = reserved; }
+
+    // Cap on the memory held by live CT nodes, in bytes (0 = no cap). Each
+    // node is charged its paths plus the constraint table and planner it
+    // created; tables and planners shared with its parent are not counted
+    // again, so this is an estimate of the real footprint. It is checked
+    // before each node is added to OPEN and never exceeded, except by a root
+    // that alone is bigger (which STOP refuses).
+    void setMemoryBudget(size_t bytes, MemoryPolicy policy = MemoryPolicy::DROP_WORST) {
+        memory_budget_ = bytes;
+        memory_policy_ = policy;
+    }
 
-    bool solve(int max_nodes = 100000) {
-        nodes_expanded_ = 0;
-        nodes_generated_ = 0;
+    // Split rectangle and corridor conflicts in one step each (symmetry.h).
+    void setSymmetryReasoning(bool on) { symmetry_ = on; }
 
-        auto root = std::make_shared<CTNode>();
+    bool solve(int max_nodes = 100000) override {
+        begin();
+        nodes_dropped_ = 0;
+        rectangle_conflicts_ = corridor_conflicts_ = 0;
+        memory_used_ = peak_memory_ = 0;
+        hit_memory_budget_ = false;
+        dropped_bound_ = std::numeric_limits<int>::max();
+
+        std::vector<CTNode*> open;
+        SolveStatus status = search(max_nodes, open);
+        for (CTNode* n : open) release(n);
+        return finish(status);
+    }
+
+    // Memory accounting of the last solve().
+    size_t getPeakMemory() const { return peak_memory_; }
+    int getNodesDropped() const { return nodes_dropped_; }
+    bool hitMemoryBudget() const { return hit_memory_budget_; }
+
+    // Conflicts of the last solve() split by symmetry reasoning.
+    int getRectangleConflicts() const { return rectangle_conflicts_; }
+    int getCorridorConflicts() const { return corridor_conflicts_; }
+
+private:
+    // OPEN is a binary heap of pool nodes, cheapest on top. Whatever is left
+    // in it when this returns is released by solve().
+    SolveStatus search(int max_nodes, std::vector<CTNode*>& open) {
+        const bool incremental = incremental_ && !reserved_;
+        auto worse = [](const CTNode* a, const CTNode* b) { return a->cost > b->cost; };
+
+        CTNode* root = pool_.acquire();
         root->paths.resize(agents_.size());
+        root->constraints = ConstraintStore((int)agents_.size());
+        root->planners.assign(incremental ? agents_.size() : 0, nullptr);
+        heuristics_.assign(agents_.size(), nullptr);
+        if (heuristic_cache_)
+            for (auto& a : agents_) heuristics_[a.id] = heuristic_cache_->get(a.goal);
+        open.push_back(root);  // released by solve() on failure
         for (auto& a : agents_) {
-            root->paths[a.id] = SpaceTimeAStar::findPath(grid_, a, {});
-            if (root->paths[a.id].empty()) {
-                std::cout << "No path exists for agent " << a.id << "\n";
-                return false;
+            if (!incremental && reusable(a))
+                root->paths[a.id] = initial_paths_[a.id];
+            else
+                root->paths[a.id] = lowLevel(a, root->constraints.forAgent(a.id));
+            if (root->paths[a.id].empty())
+                return stopRequested() ? SolveStatus::CANCELLED : SolveStatus::NO_PATH;
+            // Built only for reachable goals: with no constraints the plain
+            // search proves unreachability without exploring the time axis.
+            if (incremental) {
+                auto planner = std::make_shared<IncrementalSTAStar>(grid_, a, root->constraints.forAgent(a.id),
+                                                                    heuristic(a.id), stopFn());
+                if (planner->path().empty()) return SolveStatus::CANCELLED;
+                root->paths[a.id] = planner->path();
+                root->bytes += planner->memoryBytes();
+                root->planners[a.id] = std::move(planner);
             }
         }
         root->computeCost();
+        measure(root, 0);
         nodes_generated_++;
+        if (!fits(root->bytes)) {
+            hit_memory_budget_ = true;
+            if (memory_policy_ == MemoryPolicy::STOP) return SolveStatus::MEMORY_LIMIT;
+        }
+        charge(root);
 
-        auto cmp = [](const std::shared_ptr<CTNode>& a, const std::shared_ptr<CTNode>& b) {
-            return a->cost > b->cost;
-        };
-        std::priority_queue<std::shared_ptr<CTNode>,
-                            std::vector<std::shared_ptr<CTNode>>,
-                            decltype(cmp)> open(cmp);
-        open.push(root);
+        lower_bound_ = root->cost;
 
         while (!open.empty() && nodes_expanded_ < max_nodes) {
-            auto curr = open.top(); open.pop();
+            if (stopRequested()) return SolveStatus::CANCELLED;
+            std::pop_heap(open.begin(), open.end(), worse);
+            CTNode* curr = open.back();
+            open.pop_back();
             nodes_expanded_++;
+            lower_bound_ = std::max(lower_bound_, std::min(curr->cost, dropped_bound_));
+            progress();
 
             Conflict conflict;
             if (!findFirstConflict(curr->paths, conflict)) {
                 solution_ = curr->paths;
                 solution_cost_ = curr->cost;
-                return true;
+                release(curr);
+                return curr->cost > dropped_bound_ ? SolveStatus::SOLVED_SUBOPTIMAL : SolveStatus::SOLVED;
             }
 
-            for (int i = 0; i < 2; i++) {
-                auto child = std::make_shared<CTNode>();
+            ConflictBranches branches = split(*curr, conflict);
+            for (auto& added : branches) {
+                CTNode* child = pool_.acquire();
                 child->constraints = curr->constraints;
+                child->constraints.add(grid_, added);
 
-                Constraint new_c;
-                new_c.agent = (i == 0) ? conflict.a1 : conflict.a2;
-                new_c.timestep = conflict.timestep;
-                new_c.is_edge = conflict.is_edge;
-
-                if (!conflict.is_edge) {
-                    new_c.loc = conflict.loc;
-                    new_c.loc2 = {-1, -1};
+                int ag = added.front().agent;
+                Path new_path;
+                size_t extra = child->constraints.forAgent(ag).memoryBytes();
+                if (incremental) {
+                    auto planner = std::make_shared<IncrementalSTAStar>(*curr->planners[ag]);
+                    new_path = planner->replan(child->constraints.forAgent(ag), added, stopFn());
+                    extra += planner->memoryBytes();
+                    child->planners = curr->planners;
+                    child->planners[ag] = std::move(planner);
                 } else {
-                    if (i == 0) {
-                        new_c.loc = conflict.loc;
-                        new_c.loc2 = conflict.loc2;
-                    } else {
-                        new_c.loc = conflict.loc2;
-                        new_c.loc2 = conflict.loc;
-                    }
+                    new_path = lowLevel(agents_[ag], child->constraints.forAgent(ag));
+                }
+                if (new_path.empty()) {
+                    pool_.release(child);
+                    if (!stopRequested()) continue;
+                    release(curr);
+                    return SolveStatus::CANCELLED;
                 }
-
-                child->constraints.push_back(new_c);
 
                 child->paths = curr->paths;
-                int ag = new_c.agent;
-                Path new_path = SpaceTimeAStar::findPath(grid_, agents_[ag],
-                                                         child->constraints);
-                if (new_path.empty())
-                    continue; 
-
-                child->paths[ag] = new_path;
+                child->paths[ag] = std::move(new_path);
                 child->computeCost();
+                measure(child, extra);
                 nodes_generated_++;
-                open.push(child);
+                if (!fits(child->bytes)) {
+                    hit_memory_budget_ = true;
+                    if (memory_policy_ == MemoryPolicy::STOP) {
+                        pool_.release(child);
+                        release(curr);
+                        return SolveStatus::MEMORY_LIMIT;
+                    }
+                    makeRoom(open, *child);
+                    if (!fits(child->bytes)) {
+                        drop(child->cost);
+                        pool_.release(child);
+                        continue;
+                    }
+                }
+                charge(child);
+                open.push_back(child);
+                std::push_heap(open.begin(), open.end(), worse);
             }
+            release(curr);
         }
 
-        return false; 
+        if (!open.empty()) return SolveStatus::NODE_LIMIT;
+        // An empty OPEN only proves there is no solution if nothing was dropped.
+        return nodes_dropped_ ? SolveStatus::MEMORY_LIMIT : SolveStatus::NO_SOLUTION;
     }
 
-    const std::vector<Path>& getSolution() const { return solution_; }
-    int getSolutionCost() const { return solution_cost_; }
-    int getNodesExpanded() const { return nodes_expanded_; }
-    int getNodesGenerated() const { return nodes_generated_; }
+    bool fits(size_t bytes) const { return !memory_budget_ || memory_used_ + bytes <= memory_budget_; }
 
-private:
-    const Grid& grid_;
-    const std::vector<Agent>& agents_;
-    std::vector<Path> solution_;
-    int solution_cost_ = -1;
-    int nodes_expanded_ = 0;
-    int nodes_generated_ = 0;
-
-    static Pos getPos(const Path& path, int t) {
-        if (t < (int)path.size()) return path[t];
-        return path.back();
-    }
-
-    bool findFirstConflict(const std::vector<Path>& paths, Conflict& conflict) {
-        int num_agents = (int)paths.size();
-        int max_t = 0;
-        for (auto& p : paths) max_t = std::max(max_t, (int)p.size());
-
-        for (int a1 = 0; a1 < num_agents; a1++) {
-            for (int a2 = a1 + 1; a2 < num_agents; a2++) {
-                for (int t = 0; t < max_t; t++) {
-                    Pos p1 = getPos(paths[a1], t);
-                    Pos p2 = getPos(paths[a2], t);
-
-                    if (p1 == p2) {
-                        conflict = {a1, a2, p1, p1, t, false};
-                        return true;
-                    }
+    // Makes room for `child` by discarding the OPEN nodes no cheaper than it,
+    // most expensive first, until usage with it would be under 90% of the
+    // budget (so this doesn't run on every push). If that isn't enough, the
+    // caller drops the child itself.
+    void makeRoom(std::vector<CTNode*>& open, const CTNode& child) {
+        auto better = [](const CTNode* a, const CTNode* b) { return a->cost < b->cost; };
+        auto worse = [](const CTNode* a, const CTNode* b) { return a->cost > b->cost; };
+        std::sort(open.begin(), open.end(), better);
+        while (!open.empty() && open.back()->cost >= child.cost
+               && memory_used_ + child.bytes > memory_budget_ / 10 * 9) {
+            drop(open.back()->cost);
+            release(open.back());
+            open.pop_back();
+        }
+        std::make_heap(open.begin(), open.end(), worse);
+    }
 
-                    if (t + 1 < max_t) {
-                        Pos p1_next = getPos(paths[a1], t + 1);
-                        Pos p2_next = getPos(paths[a2], t + 1);
-                        if (p1 == p2_next && p2 == p1_next) {
-                            conflict = {a1, a2, p1, p2, t + 1, true};
-                            return true;
-                        }
-                    }
-                }
+    void drop(int cost) {
+        nodes_dropped_++;
+        dropped_bound_ = std::min(dropped_bound_, cost);
+    }
+
+    void measure(CTNode* n, size_t extra) {
+        n->bytes += sizeof(CTNode) + extra + n->paths.capacity() * sizeof(Path)
+                  + n->planners.capacity() * sizeof(n->planners[0])
+                  + (size_t)agents_.size() * sizeof(std::shared_ptr<const ConstraintTable>);
+        for (auto& p : n->paths) n->bytes += p.capacity() * sizeof(Pos);
+    }
+
+    void charge(CTNode* n) {
+        memory_used_ += n->bytes;
+        peak_memory_ = std::max(peak_memory_, memory_used_);
+    }
+
+    void release(CTNode* n) {
+        memory_used_ -= n->bytes;
+        pool_.release(n);
+    }
+
+    bool incremental_ = false;
+    bool symmetry_ = false;
+    int window_ = -1;
+    HeuristicCache* heuristic_cache_ = nullptr;
+    std::vector<std::shared_ptr<const HeuristicTable>> heuristics_;
+    std::vector<Path> initial_paths_;
+    const ReservationTable* reserved_ = nullptr;
+    size_t memory_budget_ = 0;
+    MemoryPolicy memory_policy_ = MemoryPolicy::DROP_WORST;
+    size_t memory_used_ = 0, peak_memory_ = 0;
+    int nodes_dropped_ = 0;
+    int dropped_bound_ = std::numeric_limits<int>::max();  // cheapest dropped node
+    int rectangle_conflicts_ = 0, corridor_conflicts_ = 0;
+    bool hit_memory_budget_ = false;
+    CTNodePool pool_;
+
+    const HeuristicTable* heuristic(int agent) const { return heuristics_[agent].get(); }
+
+    Path lowLevel(const Agent& a, const ConstraintTable& cons) const {
+        if (reserved_)
+            return SpaceTimeAStar::findPath(grid_, a, TableUnion(cons, *reserved_), -1, heuristic(a.id), stopFn());
+        return SpaceTimeAStar::findPath(grid_, a, cons, -1, heuristic(a.id), stopFn());
+    }
+
+    MDD mdd(int a, const ConstraintTable& cons, int cost) const {
+        if (reserved_)
+            return MDD(grid_, agents_[a], TableUnion(cons, *reserved_), cost, heuristic(a));
+        return MDD(grid_, agents_[a], cons, cost, heuristic(a));
+    }
+
+    // The children's constraints for `conflict`: a corridor or rectangle
+    // split when symmetry reasoning finds one, else the standard split.
+    ConflictBranches split(const CTNode& n, const Conflict& conflict) {
+        ConflictBranches out;
+        if (!symmetry_) return standardBranches(conflict);
+        if (corridorBranches(grid_, agents_, n.paths, conflict, out)) {
+            corridor_conflicts_++;
+            return out;
+        }
+        int a1 = conflict.a1, a2 = conflict.a2;
+        // Cheap precondition before building MDDs: both on time from their starts.
+        if (!conflict.is_edge && manhattan(agents_[a1].start, conflict.loc) == conflict.timestep
+                              && manhattan(agents_[a2].start, conflict.loc) == conflict.timestep) {
+            MDD m1 = mdd(a1, n.constraints.forAgent(a1), (int)n.paths[a1].size() - 1);
+            MDD m2 = mdd(a2, n.constraints.forAgent(a2), (int)n.paths[a2].size() - 1);
+            if (rectangleBranches(grid_, agents_, n.paths, conflict, m1, m2, out)) {
+                rectangle_conflicts_++;
+                return out;
             }
         }
-        return false;
+        return standardBranches(conflict);
+    }
+
+    bool reusable(const Agent& a) const {
+        if (reserved_ || !heuristic(a.id) || a.id >= (int)initial_paths_.size()) return false;
+        const Path& p = initial_paths_[a.id];
+        return !p.empty() && p.front() == a.start && p.back() == a.goal
+            && (int)p.size() - 1 == (*heuristic(a.id))[grid_.cellIndex(a.start)];
+    }
+
+    bool findFirstConflict(const std::vector<Path>& paths, Conflict& conflict) const {
+        return ::findFirstConflict(grid_, paths, conflict, window_ < 0 ? INT_MAX : window_);
     }
 };
\ No newline at end of file
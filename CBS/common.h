@@ -4,6 +4,8 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <cstdint>
+#include <functional>
 
 struct Pos {
     int x, y;
@@ -13,10 +15,54 @@ struct Pos {
 
 struct PosHash {
     size_t operator()(const Pos& p) const {
-        return std::hash<int>()(p.x) ^ (std::hash<int>()(p.y) << 16);
+        uint64_t k = ((uint64_t)(uint32_t)p.x << 32) | (uint32_t)p.y;
+        return (size_t)(k * 0x9E3779B97F4A7C15ull ^ (k >> 29));
     }
 };
 
+/*
+ * Compact space-time keys
+ *
+ * Cells are row-major indices (y * width + x, see Grid::cellIndex). Vertex and
+ * edge constraints, visited tables and state hashing all share one 64-bit layout:
+ *
+ *   [ timestep : 28 | move : 4 | cell : 32 ]
+ *
+ * move is 0 for a vertex (position at t) and 1..4 for the step E/W/S/N that
+ * leaves `cell` and arrives at t. That covers 2^32 cells and 2^28 timesteps.
+ */
+using StateKey = uint64_t;
+
+constexpr int kMaxTimestep = (1 << 28) - 1;
+
+enum Move : int { MOVE_NONE = 0, MOVE_E, MOVE_W, MOVE_S, MOVE_N };
+
+inline int moveBetween(Pos from, Pos to) {
+    int dx = to.x - from.x, dy = to.y - from.y;
+    if (dx == 1 && dy == 0) return MOVE_E;
+    if (dx == -1 && dy == 0) return MOVE_W;
+    if (dx == 0 && dy == 1) return MOVE_S;
+    if (dx == 0 && dy == -1) return MOVE_N;
+    return MOVE_NONE;
+}
+
+inline StateKey stateKey(int cell, int t, int move = MOVE_NONE) {
+    return ((StateKey)(uint32_t)t << 36) | ((StateKey)move << 32) | (uint32_t)cell;
+}
+inline int keyCell(StateKey k) { return (int)(uint32_t)k; }
+inline int keyTime(StateKey k) { return (int)(k >> 36); }
+inline int keyMove(StateKey k) { return (int)(k >> 32) & 0xF; }
+
+struct KeyHash {
+    size_t operator()(StateKey k) const {
+        return (size_t)((k ^ (k >> 31)) * 0x9E3779B97F4A7C15ull);
+    }
+};
+
+// Polled by the low-level searches every kStopCheckInterval expansions; once
+// it returns true they give up and return no path (MAPFSolver::cancel()).
+using StopFn = std::function<bool()>;
+constexpr int kStopCheckInterval = 1024;
 
 using Path = std::vector<Pos>;
 
@@ -33,6 +79,7 @@ struct Constraint {
     Pos loc2;       
     int timestep;
     bool is_edge;   
+    int until = -1;  // vertex only: if > timestep, blocks loc over [timestep, until]
 };
 
 struct Conflict {
@@ -45,4 +92,15 @@ struct Conflict {
 
 inline int manhattan(Pos a, Pos b) {
     return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+}
+
+// Index of the lowest set bit; v must be nonzero.
+inline int countTrailingZeros(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) { v >>= 1; n++; }
+    return n;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,224 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * Conflict detection
+ *
+ * findFirstConflict: the reference scan. It checks pair by pair (a1 < a2) and
+ * then timestep by timestep, looking for a vertex conflict at t and then an
+ * edge (swap) conflict on t -> t+1. Agents stay at their goals once their
+ * paths end.
+ *
+ * PackedSolution: the same solution stored timestep-major as cell IDs, one
+ * row of agents per timestep. Rows are padded to a multiple of 8 lanes, and
+ * short paths are padded with their goal. findFirstConflictPacked compares
+ * one agent against 8 others per instruction (AVX2, SSE2 or scalar
+ * fallback). It reports exactly the conflict the reference scan would.
+ *
+ * Both take an optional last_t: conflicts after it (by the timestep a
+ * constraint would get) are ignored, for windowed planning.
+ */
+
+inline Pos getPos(const Path& path, int t) {
+    if (t < (int)path.size()) return path[t];
+    return path.back();
+}
+
+inline bool findFirstConflict(const std::vector<Path>& paths, Conflict& conflict,
+                              int last_t = INT_MAX) {
+    int num_agents = (int)paths.size();
+    int max_t = 0;
+    for (auto& p : paths) max_t = std::max(max_t, (int)p.size());
+    if (last_t < max_t) max_t = std::max(last_t + 1, 0);
+
+    for (int a1 = 0; a1 < num_agents; a1++) {
+        for (int a2 = a1 + 1; a2 < num_agents; a2++) {
+            for (int t = 0; t < max_t; t++) {
+                Pos p1 = getPos(paths[a1], t);
+                Pos p2 = getPos(paths[a2], t);
+
+                if (p1 == p2) {
+                    conflict = {a1, a2, p1, p1, t, false};
+                    return true;
+                }
+
+                if (t + 1 < max_t) {
+                    Pos p1_next = getPos(paths[a1], t + 1);
+                    Pos p2_next = getPos(paths[a2], t + 1);
+                    if (p1 == p2_next && p2 == p1_next) {
+                        conflict = {a1, a2, p1, p2, t + 1, true};
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+class PackedSolution {
+public:
+    static constexpr int kLanes = 8;
+
+    // Only timesteps 0..last_t are stored.
+    PackedSolution(const Grid& grid, const std::vector<Path>& paths, int last_t = INT_MAX)
+        : grid_(&grid), agents_((int)paths.size())
+    {
+        stride_ = (agents_ + kLanes - 1) / kLanes * kLanes;
+        for (auto& p : paths) horizon_ = std::max(horizon_, (int)p.size());
+        if (last_t < horizon_) horizon_ = std::max(last_t + 1, 0);
+        cells_.resize((size_t)horizon_ * stride_);
+        for (int t = 0; t < horizon_; t++) {
+            int32_t* row = cells_.data() + (size_t)t * stride_;
+            for (int a = 0; a < agents_; a++)
+                row[a] = grid.cellIndex(getPos(paths[a], t));
+            // Padding lanes get distinct negative IDs so they never match.
+            for (int a = agents_; a < stride_; a++)
+                row[a] = -1 - a;
+        }
+    }
+
+    int numAgents() const { return agents_; }
+    int horizon() const { return horizon_; }
+    const int32_t* row(int t) const { return cells_.data() + (size_t)t * stride_; }
+    Pos pos(int agent, int t) const { return grid_->cellPos(row(t)[agent]); }
+
+    // Bit i set where block[i] == v.
+    static unsigned matchMask(const int32_t* block, int32_t v) {
+#if defined(__AVX2__)
+        __m256i x = _mm256_loadu_si256((const __m256i*)block);
+        __m256i eq = _mm256_cmpeq_epi32(x, _mm256_set1_epi32(v));
+        return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(eq));
+#elif defined(__SSE2__)
+        __m128i vv = _mm_set1_epi32(v);
+        __m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)block), vv);
+        __m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(block + 4)), vv);
+        return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(lo))
+             | ((unsigned)_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+#else
+        unsigned m = 0;
+        for (int i = 0; i < kLanes; i++)
+            m |= (unsigned)(block[i] == v) << i;
+        return m;
+#endif
+    }
+
+private:
+    const Grid* grid_;
+    int agents_;
+    int stride_ = 0;
+    int horizon_ = 0;
+    std::vector<int32_t> cells_;
+};
+
+inline bool findFirstConflictPacked(const PackedSolution& sol, Conflict& conflict) {
+    const int n = sol.numAgents(), T = sol.horizon();
+    const int L = PackedSolution::kLanes;
+
+    for (int a1 = 0; a1 < n; a1++) {
+        for (int base = (a1 + 1) / L * L; base < n; base += L) {
+            // Lanes still able to beat the best hit in this block: a lower
+            // a2 wins regardless of timestep, so a hit prunes every lane above it.
+            unsigned live = 0xFFu;
+            if (base <= a1) live &= ~0u << (a1 + 1 - base);
+            if (n - base < L) live &= (1u << (n - base)) - 1;
+            int hit_lane = -1, hit_t = 0;
+            bool hit_edge = false;
+
+            for (int t = 0; t < T && live; t++) {
+                const int32_t* cur = sol.row(t) + base;
+                unsigned v = PackedSolution::matchMask(cur, sol.row(t)[a1]) & live;
+                unsigned e = 0;
+                if (t + 1 < T) {
+                    const int32_t* next = sol.row(t + 1) + base;
+                    e = PackedSolution::matchMask(cur, sol.row(t + 1)[a1])
+                      & PackedSolution::matchMask(next, sol.row(t)[a1]) & live;
+                }
+                if (unsigned any = v | e) {
+                    // Vertex at t is checked before the swap on t -> t+1.
+                    int lane = countTrailingZeros(any);
+                    hit_lane = lane; hit_t = t; hit_edge = !((v >> lane) & 1u);
+                    live &= (1u << lane) - 1;
+                }
+            }
+
+            if (hit_lane >= 0) {
+                int a2 = base + hit_lane;
+                Pos p1 = sol.pos(a1, hit_t), p2 = sol.pos(a2, hit_t);
+                if (!hit_edge) conflict = {a1, a2, p1, p1, hit_t, false};
+                else conflict = {a1, a2, p1, p2, hit_t + 1, true};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// From this many agents on, findFirstConflict(grid, ...) scans the packed
+// layout instead of pair by pair.
+constexpr int kPackedConflictMinAgents = 32;
+
+inline bool findFirstConflict(const Grid& grid, const std::vector<Path>& paths,
+                              Conflict& conflict, int last_t = INT_MAX) {
+    if ((int)paths.size() < kPackedConflictMinAgents)
+        return findFirstConflict(paths, conflict, last_t);
+    PackedSolution packed(grid, paths, last_t);
+    return findFirstConflictPacked(packed, conflict);
+}
+
+// True if the two agents collide anywhere, waiting at their goals after
+// their paths end.
+inline bool pathsConflict(const Path& p1, const Path& p2) {
+    int max_t = (int)std::max(p1.size(), p2.size());
+    for (int t = 0; t < max_t; t++) {
+        Pos a = getPos(p1, t), b = getPos(p2, t);
+        if (a == b) return true;
+        if (t + 1 < max_t && a == getPos(p2, t + 1) && b == getPos(p1, t + 1)) return true;
+    }
+    return false;
+}
+
+// Pairs (a1 < a2) of agents that collide somewhere, each pair once. Agents
+// meeting at one cell are all paired with the first of them, which is enough
+// to find connected groups. Hashes occupancy per timestep instead of
+// comparing all pairs.
+inline std::vector<std::pair<int, int>> findConflictingPairs(const Grid& grid,
+                                                             const std::vector<Path>& paths) {
+    int max_t = 0;
+    for (auto& p : paths) max_t = std::max(max_t, (int)p.size());
+
+    std::vector<std::pair<int, int>> pairs;
+    std::unordered_map<int, int> at;              // cell -> agent, at t
+    std::unordered_map<StateKey, int, KeyHash> moves;  // edge into t -> agent
+    auto report = [&](int a, int b) { pairs.push_back({std::min(a, b), std::max(a, b)}); };
+
+    for (int t = 0; t < max_t; t++) {
+        at.clear();
+        moves.clear();
+        for (int a = 0; a < (int)paths.size(); a++) {
+            Pos p = getPos(paths[a], t);
+            auto [it, fresh] = at.try_emplace(grid.cellIndex(p), a);
+            if (!fresh) report(it->second, a);
+            if (t == 0) continue;
+            Pos prev = getPos(paths[a], t - 1);
+            if (prev == p) continue;
+            auto swap = moves.find(grid.edgeKey(p, prev, t));
+            if (swap != moves.end()) report(swap->second, a);
+            moves.emplace(grid.edgeKey(prev, p, t), a);
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    return pairs;
+}
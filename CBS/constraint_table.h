@@ -0,0 +1,113 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+ * Constraint tables
+ *
+ * ConstraintTable: every constraint on one agent, kept sorted by timestep,
+ * plus a StateKey index the low level probes directly. It also tracks the
+ * latest constrained timestep overall (after it, time no longer matters) and
+ * per cell (an agent may only stop at its goal after the last constraint there).
+ * Range constraints (Constraint::until) are kept as per-cell intervals.
+ *
+ * ConstraintStore: one immutable, shared ConstraintTable per agent. A CT child
+ * copies its parent's store (k pointers) and rebuilds only the table of the
+ * agent that received the new constraint.
+ */
+
+class ConstraintTable {
+public:
+    void add(const Grid& grid, const Constraint& c) {
+        auto pos = std::upper_bound(sorted_.begin(), sorted_.end(), c.timestep,
+            [](int t, const Constraint& o) { return t < o.timestep; });
+        sorted_.insert(pos, c);
+        int last = c.is_edge ? c.timestep : std::max(c.timestep, c.until);
+        latest_ = std::max(latest_, last);
+        if (!c.is_edge) {
+            if (last > c.timestep)
+                ranges_[grid.cellIndex(c.loc)].push_back({c.timestep, last});
+            else
+                keys_.insert(grid.vertexKey(c.loc, c.timestep));
+            int& at = latest_at_.try_emplace(grid.cellIndex(c.loc), -1).first->second;
+            at = std::max(at, last);
+        } else {
+            keys_.insert(grid.edgeKey(c.loc, c.loc2, c.timestep));
+        }
+    }
+
+    // key is Grid::vertexKey or Grid::edgeKey at the arrival timestep.
+    bool blocked(StateKey key) const {
+        if (keyTime(key) > latest_) return false;
+        if (keys_.count(key)) return true;
+        if (ranges_.empty() || keyMove(key) != MOVE_NONE) return false;
+        auto it = ranges_.find(keyCell(key));
+        if (it == ranges_.end()) return false;
+        for (auto [from, to] : it->second)
+            if (keyTime(key) >= from && keyTime(key) <= to) return true;
+        return false;
+    }
+
+    int latestTimestep() const { return latest_; }
+
+    int latestAt(int cell) const {
+        auto it = latest_at_.find(cell);
+        return it == latest_at_.end() ? -1 : it->second;
+    }
+
+    const std::vector<Constraint>& constraints() const { return sorted_; }
+    size_t size() const { return sorted_.size(); }
+    bool empty() const { return sorted_.empty(); }
+
+    // Approximate heap footprint (hash nodes counted as key + next pointer).
+    size_t memoryBytes() const {
+        return sizeof(*this) + sorted_.capacity() * sizeof(Constraint)
+             + keys_.size() * (sizeof(StateKey) + sizeof(void*)) + keys_.bucket_count() * sizeof(void*)
+             + latest_at_.size() * (2 * sizeof(int) + sizeof(void*)) + latest_at_.bucket_count() * sizeof(void*)
+             + ranges_.size() * (sizeof(int) + 2 * sizeof(void*) + 2 * sizeof(int));
+    }
+
+private:
+    std::vector<Constraint> sorted_;
+    std::unordered_set<StateKey, KeyHash> keys_;
+    std::unordered_map<int, int> latest_at_;
+    std::unordered_map<int, std::vector<std::pair<int, int>>> ranges_;  // cell -> [from, to]
+    int latest_ = -1;
+};
+
+class ConstraintStore {
+public:
+    explicit ConstraintStore(int num_agents = 0) : tables_(num_agents) {}
+
+    const ConstraintTable& forAgent(int agent) const {
+        static const ConstraintTable kEmpty;
+        return tables_[agent] ? *tables_[agent] : kEmpty;
+    }
+
+    // Drops every table but keeps the slots, for reuse of a pooled CT node.
+    void clear() {
+        for (auto& t : tables_) t.reset();
+        size_ = 0;
+    }
+
+    void add(const Grid& grid, const Constraint& c) { add(grid, std::vector<Constraint>{c}); }
+
+    // All of `cs` must be on the same agent; its table is copied once.
+    void add(const Grid& grid, const std::vector<Constraint>& cs) {
+        int agent = cs.front().agent;
+        auto table = tables_[agent] ? std::make_shared<ConstraintTable>(*tables_[agent])
+                                    : std::make_shared<ConstraintTable>();
+        for (auto& c : cs) table->add(grid, c);
+        tables_[agent] = std::move(table);
+        size_ += cs.size();
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    std::vector<std::shared_ptr<const ConstraintTable>> tables_;
+    size_t size_ = 0;
+};
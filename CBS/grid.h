@@ -21,15 +21,36 @@ public:
         return inBounds(p) && !obstacles[p.y * width + p.x];
     }
 
+    int cellIndex(Pos p) const { return p.y * width + p.x; }
+    Pos cellPos(int cell) const { return {cell % width, cell / width}; }
+
+    StateKey vertexKey(Pos p, int t) const { return stateKey(cellIndex(p), t); }
+    StateKey edgeKey(Pos from, Pos to, int t) const {
+        return stateKey(cellIndex(from), t, moveBetween(from, to));
+    }
+
+    // Free 4-neighbors of p.
+    int degree(Pos p) const {
+        int n = 0;
+        forEachNeighbor(p, [&](Pos q) { n += !(q == p); });
+        return n;
+    }
+
     std::vector<Pos> getNeighbors(Pos p) const {
         std::vector<Pos> result;
-        Pos dirs[] = {{1,0},{-1,0},{0,1},{0,-1},{0,0}};
+        forEachNeighbor(p, [&](Pos next) { result.push_back(next); });
+        return result;
+    }
+
+    // Allocation-free getNeighbors for hot loops; same order, wait included.
+    template <typename Fn>
+    void forEachNeighbor(Pos p, Fn fn) const {
+        static const Pos dirs[] = {{1,0},{-1,0},{0,1},{0,-1},{0,0}};
         for (auto& d : dirs) {
             Pos next = {p.x + d.x, p.y + d.y};
             if (isFree(next))
-                result.push_back(next);
+                fn(next);
         }
-        return result;
     }
 
     void print(const std::vector<Agent>& agents) const {
@@ -0,0 +1,114 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "map_cache.h"
+#include <cstring>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+/*
+ * Goal distance tables
+ *
+ * computeDistanceTable: BFS from a goal over free cells (4-connected). The
+ * result is the exact obstacle-aware distance to the goal for every cell, or
+ * kUnreachable. That is a perfect spatial heuristic for the low level, and it
+ * lets a search reject unreachable goals without expanding anything.
+ *
+ * HeuristicCache: tables keyed by goal cell, shared across CBS instances
+ * (e.g. between rolling-horizon replans). Least recently used tables are
+ * evicted once they take more than `max_bytes` (4 bytes per cell each; at
+ * least one is kept). Tables still held by a caller stay alive until it
+ * drops them. With a MapCache attached
+ * (map_cache.h), a miss is served from the persistent file when it has the
+ * table, and newly computed tables are added to it.
+ */
+
+using HeuristicTable = std::vector<int>;
+
+constexpr int kUnreachable = INT_MAX / 4;
+
+inline HeuristicTable computeDistanceTable(const Grid& grid, Pos goal) {
+    HeuristicTable dist((size_t)grid.width * grid.height, kUnreachable);
+    if (!grid.isFree(goal)) return dist;
+    std::vector<int> queue;
+    queue.reserve(dist.size());
+    queue.push_back(grid.cellIndex(goal));
+    dist[queue[0]] = 0;
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        Pos p = grid.cellPos(cell);
+        grid.forEachNeighbor(p, [&](Pos q) {
+            int n = grid.cellIndex(q);
+            if (dist[n] != kUnreachable) return;
+            dist[n] = dist[cell] + 1;
+            queue.push_back(n);
+        });
+    }
+    return dist;
+}
+
+class HeuristicCache {
+public:
+    static constexpr size_t kDefaultBytes = size_t(256) << 20;
+
+    explicit HeuristicCache(const Grid& grid, size_t max_bytes = kDefaultBytes)
+        : grid_(grid), max_bytes_(max_bytes) {}
+
+    // Bytes of one table for `grid`.
+    static size_t tableBytes(const Grid& grid) {
+        return (size_t)grid.width * grid.height * sizeof(HeuristicTable::value_type);
+    }
+
+    std::shared_ptr<const HeuristicTable> get(Pos goal) {
+        int cell = grid_.cellIndex(goal);
+        auto it = tables_.find(cell);
+        if (it != tables_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.second);
+            return it->second.first;
+        }
+        auto table = std::make_shared<const HeuristicTable>(loadOrCompute(goal));
+        lru_.push_front(cell);
+        tables_[cell] = {table, lru_.begin()};
+        while (tables_.size() > 1 && bytes() > max_bytes_) {
+            tables_.erase(lru_.back());
+            lru_.pop_back();
+        }
+        return table;
+    }
+
+    size_t size() const { return tables_.size(); }
+    size_t bytes() const { return tables_.size() * tableBytes(grid_); }
+    const Grid& grid() const { return grid_; }
+
+    // Persistent backing store for this grid; must outlive the cache. New
+    // tables are written to disk once the store's pending buffer fills, and
+    // the rest by store->flush().
+    void setStore(MapCache* store) { store_ = store; }
+
+private:
+    const Grid& grid_;
+    size_t max_bytes_;
+    MapCache* store_ = nullptr;
+
+    HeuristicTable loadOrCompute(Pos goal) {
+        static_assert(sizeof(HeuristicTable::value_type) == sizeof(int32_t), "stored as int32");
+        const size_t cells = (size_t)grid_.width * grid_.height;
+        const int cell = grid_.cellIndex(goal);
+        if (store_) {
+            auto [data, bytes] = store_->find(MapCache::DISTANCE_TABLE, cell);
+            if (data && bytes == cells * sizeof(int32_t)) {
+                HeuristicTable table(cells);
+                std::memcpy(table.data(), data, bytes);
+                return table;
+            }
+        }
+        HeuristicTable table = computeDistanceTable(grid_, goal);
+        if (store_) store_->put(MapCache::DISTANCE_TABLE, cell, table.data(), cells * sizeof(int32_t));
+        return table;
+    }
+
+    std::list<int> lru_;
+    std::unordered_map<int, std::pair<std::shared_ptr<const HeuristicTable>,
+                                      std::list<int>::iterator>> tables_;
+};
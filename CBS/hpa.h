@@ -0,0 +1,644 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "heuristic.h"
+#include <queue>
+
+/*
+ * Hierarchical path abstraction (HPA*, Botea et al., 2004)
+ *
+ * Level 1 cuts the map into size x size clusters. Wherever free cells face
+ * each other across a cluster border, each maximal run of such pairs is an
+ * entrance with one transition (a pair of cells, one per side) in its middle,
+ * or two at its ends if it is wide. Transition cells are the abstract nodes:
+ * the two of a pair are joined by 1, and nodes of one cluster by their
+ * shortest distance inside it. Level l has clusters 2^(l-1) times as wide and
+ * keeps the nodes on their borders, joined by shortest distances over level 1
+ * inside the larger cluster.
+ *
+ * plan() connects start and goal to their clusters' nodes, runs A* on the
+ * coarsest level that separates them, and returns an HPAPath that is turned
+ * into cells one leg at a time as the caller reads it. Every edge is a real
+ * path, so the refined path has exactly the abstract cost; it can be a few
+ * percent longer than optimal, since it must pass through transitions.
+ *
+ * HierarchicalHeuristic turns the same graph into a goal distance estimate
+ * for the low level. It is an upper bound, not admissible, so it suits
+ * planners that don't promise optimal paths anyway (prioritized planning);
+ * what it buys is that nothing is computed or stored for clusters the search
+ * never reaches, where a distance table costs a BFS over the whole map and
+ * 4 bytes per cell for every goal.
+ *
+ * memoryBytes(level) reports what each level holds; level 0 is the grid.
+ * Queries are const and may run concurrently.
+ */
+
+class HPAPath;
+
+class ClusterHierarchy {
+public:
+    struct LevelStats {
+        int cluster_size;  // cells per cluster side
+        int clusters;
+        int nodes;
+        int edges;         // within clusters, directed
+        size_t bytes;
+    };
+
+    // Levels stop early once one cluster covers the map.
+    ClusterHierarchy(const Grid& grid, int cluster_size = 16, int levels = 2)
+        : grid_(grid)
+    {
+        cluster_size = std::max(cluster_size, 2);
+        for (int l = 1; l <= std::max(levels, 1); l++) {
+            Level L;
+            L.size = cluster_size << (l - 1);
+            L.cols = (grid.width + L.size - 1) / L.size;
+            L.rows = (grid.height + L.size - 1) / L.size;
+            levels_.push_back(std::move(L));
+            if (levels_.back().cols * levels_.back().rows <= 1) break;
+        }
+        buildEntrances();
+        buildLevel1();
+        for (int l = 2; l <= this->levels(); l++) buildLevel(l);
+    }
+
+    const Grid& grid() const { return grid_; }
+    int levels() const { return (int)levels_.size(); }
+    int clusterSize(int level) const { return level == 0 ? 1 : levels_[level - 1].size; }
+
+    LevelStats stats(int level) const {
+        if (level == 0) {
+            int free_cells = (int)std::count(grid_.obstacles.begin(), grid_.obstacles.end(), false);
+            return {1, grid_.width * grid_.height, free_cells, 0, memoryBytes(0)};
+        }
+        const Level& L = levels_[level - 1];
+        return {L.size, L.cols * L.rows, L.nodes, (int)L.edges.size(), memoryBytes(level)};
+    }
+
+    // Bytes held by one level: the obstacle bits for level 0, the graph for
+    // the others (level 1 also holds the node list).
+    size_t memoryBytes(int level) const {
+        if (level == 0) return sizeof(Grid) + (grid_.obstacles.size() + 7) / 8;
+        const Level& L = levels_[level - 1];
+        size_t bytes = sizeof(Level) + L.offset.capacity() * sizeof(int)
+                     + L.edges.capacity() * sizeof(Edge)
+                     + L.members.capacity() * sizeof(std::vector<int>);
+        for (auto& m : L.members) bytes += m.capacity() * sizeof(int);
+        if (level == 1) bytes += nodes_.capacity() * sizeof(Node);
+        return bytes;
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = 0;
+        for (int l = 0; l <= levels(); l++) bytes += memoryBytes(l);
+        return bytes;
+    }
+
+    // Route from `from` to `to`, refined into cells on demand.
+    inline HPAPath plan(Pos from, Pos to) const;
+
+private:
+    friend class HPAPath;
+    friend class HierarchicalHeuristic;
+
+    // Entrances at least this wide get a transition at each end.
+    static constexpr int kWideEntrance = 6;
+
+    struct Edge { int to, cost; };
+    struct Node {
+        int cell;
+        int partner;  // the other cell of the transition
+        int cluster;  // on level 1
+    };
+    struct Level {
+        int size, cols, rows;
+        int nodes = 0;
+        std::vector<std::vector<int>> members;  // cluster -> its nodes on this level
+        std::vector<int> offset;                // node -> edges[offset[n], offset[n + 1])
+        std::vector<Edge> edges;                // inside a cluster; partners are implicit
+    };
+    // Per-query Dijkstra state over all nodes plus a virtual goal.
+    struct Scratch {
+        std::vector<int> dist, parent, touched;
+        explicit Scratch(const ClusterHierarchy& h)
+            : dist(h.nodes_.size() + 1, kUnreachable), parent(h.nodes_.size() + 1, -1) {}
+        void set(int n, int d, int from) {
+            if (dist[n] == kUnreachable) touched.push_back(n);
+            dist[n] = d;
+            parent[n] = from;
+        }
+        void clear() {
+            for (int n : touched) { dist[n] = kUnreachable; parent[n] = -1; }
+            touched.clear();
+        }
+    };
+    using Seeds = std::vector<std::pair<int, int>>;  // (node or cell, distance)
+
+    const Grid& grid_;
+    std::vector<Node> nodes_;
+    std::vector<Level> levels_;  // levels_[l - 1] is level l
+
+    int clusterOf(int level, Pos p) const {
+        const Level& L = levels_[level - 1];
+        return (p.y / L.size) * L.cols + p.x / L.size;
+    }
+    int clusterOf(int level, int node) const {
+        return level == 1 ? nodes_[node].cluster : clusterOf(level, grid_.cellPos(nodes_[node].cell));
+    }
+    // A node is on level l if its transition crosses a level-l border.
+    bool onLevel(int level, int node) const {
+        return clusterOf(level, node) != clusterOf(level, nodes_[node].partner);
+    }
+
+    // Level-1 cluster c as [x0, x1) x [y0, y1).
+    void bounds(int c, int& x0, int& y0, int& x1, int& y1) const {
+        const Level& L = levels_[0];
+        x0 = c % L.cols * L.size;
+        y0 = c / L.cols * L.size;
+        x1 = std::min(x0 + L.size, grid_.width);
+        y1 = std::min(y0 + L.size, grid_.height);
+    }
+    int localIndex(int c, Pos p) const {
+        int x0, y0, x1, y1;
+        bounds(c, x0, y0, x1, y1);
+        return (p.y - y0) * (x1 - x0) + (p.x - x0);
+    }
+
+    void buildEntrances() {
+        const int C = levels_[0].size;
+        for (int x = C; x < grid_.width; x += C)
+            for (int y = 0; y < grid_.height; y += C)
+                addEntrances({x - 1, y}, {x, y}, {0, 1}, std::min(C, grid_.height - y));
+        for (int y = C; y < grid_.height; y += C)
+            for (int x = 0; x < grid_.width; x += C)
+                addEntrances({x, y - 1}, {x, y}, {1, 0}, std::min(C, grid_.width - x));
+    }
+
+    // Transitions for the maximal runs of free pairs (a0 + i*step, b0 + i*step).
+    void addEntrances(Pos a0, Pos b0, Pos step, int len) {
+        int run = 0;
+        for (int i = 0; i <= len; i++) {
+            Pos a = {a0.x + i * step.x, a0.y + i * step.y};
+            Pos b = {b0.x + i * step.x, b0.y + i * step.y};
+            if (i < len && grid_.isFree(a) && grid_.isFree(b)) {
+                run++;
+                continue;
+            }
+            if (run >= kWideEntrance) {
+                addTransition(a0, b0, step, i - run);
+                addTransition(a0, b0, step, i - 1);
+            } else if (run) {
+                addTransition(a0, b0, step, i - run + run / 2);
+            }
+            run = 0;
+        }
+    }
+
+    void addTransition(Pos a0, Pos b0, Pos step, int i) {
+        Pos a = {a0.x + i * step.x, a0.y + i * step.y};
+        Pos b = {b0.x + i * step.x, b0.y + i * step.y};
+        int n = (int)nodes_.size();
+        nodes_.push_back({grid_.cellIndex(a), n + 1, clusterOf(1, a)});
+        nodes_.push_back({grid_.cellIndex(b), n, clusterOf(1, b)});
+    }
+
+    // Packs per-node edge lists into the level's offset/edges arrays.
+    static void pack(Level& L, const std::vector<std::vector<Edge>>& adj) {
+        L.offset.assign(adj.size() + 1, 0);
+        for (size_t n = 0; n < adj.size(); n++) L.offset[n + 1] = L.offset[n] + (int)adj[n].size();
+        L.edges.reserve(L.offset.back());
+        for (auto& list : adj) L.edges.insert(L.edges.end(), list.begin(), list.end());
+    }
+
+    void buildLevel1() {
+        Level& L = levels_[0];
+        L.members.assign((size_t)L.cols * L.rows, {});
+        for (int n = 0; n < (int)nodes_.size(); n++) L.members[nodes_[n].cluster].push_back(n);
+        L.nodes = (int)nodes_.size();
+
+        std::vector<std::vector<Edge>> adj(nodes_.size());
+        std::vector<int> dist;
+        for (int c = 0; c < (int)L.members.size(); c++) {
+            for (int n : L.members[c]) {
+                clusterDistances(c, {{nodes_[n].cell, 0}}, dist);
+                for (int m : L.members[c]) {
+                    int d = dist[localIndex(c, grid_.cellPos(nodes_[m].cell))];
+                    if (m != n && d < kUnreachable) adj[n].push_back({m, d});
+                }
+            }
+        }
+        pack(L, adj);
+    }
+
+    void buildLevel(int level) {
+        Level& L = levels_[level - 1];
+        L.members.assign((size_t)L.cols * L.rows, {});
+        for (int n = 0; n < (int)nodes_.size(); n++)
+            if (onLevel(level, n)) {
+                L.members[clusterOf(level, n)].push_back(n);
+                L.nodes++;
+            }
+
+        std::vector<std::vector<Edge>> adj(nodes_.size());
+        Scratch s(*this);
+        for (int c = 0; c < (int)L.members.size(); c++) {
+            for (int n : L.members[c]) {
+                dijkstra({{n, 0}}, level, c, -1, s);
+                for (int m : L.members[c])
+                    if (m != n && s.dist[m] < kUnreachable) adj[n].push_back({m, s.dist[m]});
+                s.clear();
+            }
+        }
+        pack(L, adj);
+    }
+
+    // Distances inside level-1 cluster c from `seeds` (cell, initial
+    // distance), indexed by localIndex().
+    void clusterDistances(int c, const Seeds& seeds, std::vector<int>& dist) const {
+        int x0, y0, x1, y1;
+        bounds(c, x0, y0, x1, y1);
+        const int w = x1 - x0;
+        dist.assign((size_t)w * (y1 - y0), kUnreachable);
+        auto local = [&](Pos p) { return (p.y - y0) * w + (p.x - x0); };
+        auto inside = [&](Pos p) { return p.x >= x0 && p.x < x1 && p.y >= y0 && p.y < y1; };
+
+        if (seeds.size() == 1 && seeds[0].second == 0) {  // plain BFS
+            std::vector<int> queue = {local(grid_.cellPos(seeds[0].first))};
+            dist[queue[0]] = 0;
+            for (size_t head = 0; head < queue.size(); head++) {
+                const int l = queue[head];
+                grid_.forEachNeighbor({x0 + l % w, y0 + l / w}, [&](Pos q) {
+                    if (!inside(q) || dist[local(q)] != kUnreachable) return;
+                    dist[local(q)] = dist[l] + 1;
+                    queue.push_back(local(q));
+                });
+            }
+            return;
+        }
+        using Item = std::pair<int, int>;  // (distance, local cell)
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+        for (auto& sd : seeds) {
+            int l = local(grid_.cellPos(sd.first));
+            if (sd.second < dist[l]) {
+                dist[l] = sd.second;
+                open.push({sd.second, l});
+            }
+        }
+        while (!open.empty()) {
+            auto [d, l] = open.top();
+            open.pop();
+            if (d > dist[l]) continue;
+            grid_.forEachNeighbor({x0 + l % w, y0 + l / w}, [&](Pos q) {
+                if (!inside(q) || dist[local(q)] <= d + 1) return;
+                dist[local(q)] = d + 1;
+                open.push({d + 1, local(q)});
+            });
+        }
+    }
+
+    // Calls fn(node, cost) for each edge out of n on `level`.
+    template <typename Fn>
+    void forEachEdge(int level, int n, Fn fn) const {
+        fn(nodes_[n].partner, 1);
+        const Level& L = levels_[level - 1];
+        for (int e = L.offset[n]; e < L.offset[n + 1]; e++) fn(L.edges[e].to, L.edges[e].cost);
+    }
+
+    // Dijkstra over level 1 from `seeds` (node, distance), keeping to the
+    // nodes of cluster c on `level` (c < 0: anywhere). Stops once `stop` is
+    // settled. Results stay in s until s.clear().
+    void dijkstra(const Seeds& seeds, int level, int c, int stop, Scratch& s) const {
+        using Item = std::pair<int, int>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+        for (auto& [n, d] : seeds)
+            if (d < s.dist[n]) {
+                s.set(n, d, -1);
+                open.push({d, n});
+            }
+        while (!open.empty()) {
+            auto [d, n] = open.top();
+            open.pop();
+            if (d > s.dist[n]) continue;
+            if (n == stop) return;
+            forEachEdge(1, n, [&](int m, int cost) {
+                if (c >= 0 && clusterOf(level, m) != c) return;
+                if (d + cost < s.dist[m]) {
+                    s.set(m, d + cost, n);
+                    open.push({d + cost, m});
+                }
+            });
+        }
+    }
+
+    // p's neighbours on `level`: that level's nodes in p's cluster, with
+    // distances from p over level 1 without leaving the cluster.
+    Seeds connect(int level, Pos p, Scratch& s) const {
+        const int c1 = clusterOf(1, p);
+        std::vector<int> dist;
+        clusterDistances(c1, {{grid_.cellIndex(p), 0}}, dist);
+        Seeds out;
+        for (int n : levels_[0].members[c1]) {
+            int d = dist[localIndex(c1, grid_.cellPos(nodes_[n].cell))];
+            if (d < kUnreachable) out.push_back({n, d});
+        }
+        if (level == 1) return out;
+        const int c = clusterOf(level, p);
+        dijkstra(out, level, c, -1, s);
+        out.clear();
+        for (int n : levels_[level - 1].members[c])
+            if (s.dist[n] < kUnreachable) out.push_back({n, s.dist[n]});
+        s.clear();
+        return out;
+    }
+
+    // Length of the abstract path from `from` to `to`, and the level-1 nodes
+    // along it (empty if it stays inside one level-1 cluster).
+    int search(Pos from, Pos to, Scratch& s, std::vector<int>& route) const {
+        route.clear();
+        if (!grid_.isFree(from) || !grid_.isFree(to)) return kUnreachable;
+        if (from == to) return 0;
+
+        int direct = kUnreachable;
+        const int c1 = clusterOf(1, from);
+        if (c1 == clusterOf(1, to)) {
+            std::vector<int> dist;
+            clusterDistances(c1, {{grid_.cellIndex(from), 0}}, dist);
+            direct = dist[localIndex(c1, to)];
+        }
+        // The coarsest level whose clusters separate the two.
+        int q = 1;
+        for (int l = levels(); l > 1; l--)
+            if (clusterOf(l, from) != clusterOf(l, to)) { q = l; break; }
+
+        const Seeds src = connect(q, from, s), dst = connect(q, to, s);
+        std::vector<int> top;
+        int cost = astar(q, src, dst, to, s, top);
+        if (direct <= cost) return direct;
+        refine(q, from, to, top, s, route);
+        return cost;
+    }
+
+    // A* on `level` from the src nodes to a virtual goal behind the dst
+    // nodes. The nodes along the way go to `out`.
+    int astar(int level, const Seeds& src, const Seeds& dst, Pos to, Scratch& s,
+              std::vector<int>& out) const {
+        const int goal = (int)nodes_.size();
+        auto h = [&](int n) { return manhattan(grid_.cellPos(nodes_[n].cell), to); };
+        using Item = std::pair<int, int>;  // (f, node)
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+        for (auto& [n, d] : src)
+            if (d < s.dist[n]) {
+                s.set(n, d, -1);
+                open.push({d + h(n), n});
+            }
+        int cost = kUnreachable;
+        while (!open.empty()) {
+            auto [f, n] = open.top();
+            open.pop();
+            if (n == goal) {
+                cost = s.dist[goal];
+                break;
+            }
+            const int d = s.dist[n];
+            if (f > d + h(n)) continue;
+            auto relax = [&](int m, int nd, int hm) {
+                if (nd >= s.dist[m]) return;
+                s.set(m, nd, n);
+                open.push({nd + hm, m});
+            };
+            for (auto& [m, dm] : dst)
+                if (m == n) relax(goal, d + dm, 0);
+            forEachEdge(level, n, [&](int m, int c) { relax(m, d + c, h(m)); });
+        }
+        out.clear();
+        if (cost < kUnreachable)
+            for (int n = s.parent[goal]; n >= 0; n = s.parent[n]) out.push_back(n);
+        std::reverse(out.begin(), out.end());
+        s.clear();
+        return cost;
+    }
+
+    // Expands a route on `level` into the level-1 nodes it passes through.
+    void refine(int level, Pos from, Pos to, const std::vector<int>& top, Scratch& s,
+                std::vector<int>& out) const {
+        out.clear();
+        if (top.empty()) return;
+        // Appends the level-1 path to `stop`, from the seed it started at.
+        auto walk = [&](int stop) {
+            size_t at = out.size();
+            for (int n = stop; n >= 0; n = s.parent[n]) out.push_back(n);
+            std::reverse(out.begin() + at, out.end());
+            s.clear();
+        };
+        if (level == 1) {
+            out = top;
+            return;
+        }
+        // Into the first node, along each edge within a cluster, and from
+        // the last node to the level-1 node the goal is reached from.
+        dijkstra(connect(1, from, s), level, clusterOf(level, from), top.front(), s);
+        walk(top.front());
+        for (size_t i = 1; i < top.size(); i++) {
+            int u = top[i - 1], v = top[i];
+            if (nodes_[u].partner == v) {
+                out.push_back(v);
+                continue;
+            }
+            out.pop_back();
+            dijkstra({{u, 0}}, level, clusterOf(level, u), v, s);
+            walk(v);
+        }
+        const Seeds dst = connect(1, to, s);
+        out.pop_back();
+        dijkstra({{top.back(), 0}}, level, clusterOf(level, to), -1, s);
+        int best = -1, best_d = kUnreachable;
+        for (auto& [n, d] : dst)
+            if (s.dist[n] < kUnreachable && s.dist[n] + d < best_d) {
+                best = n;
+                best_d = s.dist[n] + d;
+            }
+        walk(best);
+    }
+
+    // Shortest walk from p to `target` inside p's level-1 cluster; the cells
+    // after p.
+    Path walkInCluster(Pos p, Pos target) const {
+        int x0, y0, x1, y1;
+        bounds(clusterOf(1, p), x0, y0, x1, y1);
+        const int w = x1 - x0;
+        auto local = [&](Pos q) { return (q.y - y0) * w + (q.x - x0); };
+        std::vector<int> parent((size_t)w * (y1 - y0), -2);
+        std::vector<Pos> queue = {p};
+        parent[local(p)] = -1;
+        for (size_t head = 0; head < queue.size(); head++) {
+            Pos at = queue[head];
+            if (at == target) {
+                Path out;
+                for (int l = local(at); l != local(p); l = parent[l]) out.push_back({x0 + l % w, y0 + l / w});
+                std::reverse(out.begin(), out.end());
+                return out;
+            }
+            grid_.forEachNeighbor(at, [&](Pos q) {
+                if (q.x < x0 || q.x >= x1 || q.y < y0 || q.y >= y1 || parent[local(q)] != -2) return;
+                parent[local(q)] = local(at);
+                queue.push_back(q);
+            });
+        }
+        return {};
+    }
+};
+
+/*
+ * A plan() result. route() is known up front; cells() grows by one leg per
+ * refineNext() (a walk inside a cluster, or the step across a transition),
+ * so a caller that only needs the first stretch never pays for the rest.
+ */
+class HPAPath {
+public:
+    bool found() const { return cost_ < kUnreachable; }
+    // Length of the path once fully refined.
+    int cost() const { return cost_; }
+    // Level-1 nodes the path passes through.
+    const std::vector<int>& route() const { return route_; }
+
+    bool complete() const { return done_; }
+    const Path& cells() const { return cells_; }
+
+    // Adds the next leg to cells(); false once the goal has been reached.
+    bool refineNext() {
+        if (done_) return false;
+        const ClusterHierarchy& h = *h_;
+        const Pos p = cells_.back();
+        if (next_ == route_.size()) {
+            Path leg = h.walkInCluster(p, goal_);
+            cells_.insert(cells_.end(), leg.begin(), leg.end());
+            done_ = true;
+            return true;
+        }
+        const int n = route_[next_++];
+        Pos target = h.grid_.cellPos(h.nodes_[n].cell);
+        if (next_ > 1 && h.nodes_[route_[next_ - 2]].partner == n) {
+            cells_.push_back(target);
+        } else {
+            Path leg = h.walkInCluster(p, target);
+            cells_.insert(cells_.end(), leg.begin(), leg.end());
+        }
+        return true;
+    }
+
+    // Refines until cells()[t] exists or the path is complete; the goal
+    // after the end.
+    Pos at(int t) {
+        while ((int)cells_.size() <= t && refineNext()) {}
+        return t < (int)cells_.size() ? cells_[t] : cells_.back();
+    }
+
+    Path full() {
+        while (refineNext()) {}
+        return cells_;
+    }
+
+private:
+    friend class ClusterHierarchy;
+    const ClusterHierarchy* h_ = nullptr;
+    Pos goal_ = {-1, -1};
+    std::vector<int> route_;
+    size_t next_ = 0;
+    Path cells_;
+    int cost_ = kUnreachable;
+    bool done_ = true;
+};
+
+inline HPAPath ClusterHierarchy::plan(Pos from, Pos to) const {
+    HPAPath path;
+    Scratch s(*this);
+    path.cost_ = search(from, to, s, path.route_);
+    if (!path.found()) return path;
+    path.h_ = this;
+    path.goal_ = to;
+    path.cells_ = {from};
+    path.done_ = from == to;
+    return path;
+}
+
+/*
+ * Goal distance estimate from a ClusterHierarchy: inside the goal's cluster
+ * the exact distance, elsewhere the shortest way to the goal through the
+ * cluster's transitions. Never below the true distance, and kUnreachable
+ * exactly where the goal can't be reached.
+ *
+ * Lazy in both directions: the Dijkstra over level 1 out from the goal runs
+ * only until the transitions of the clusters asked about are settled, and a
+ * cluster's cells are filled in the first time one of them is asked about.
+ * Not thread-safe.
+ */
+class HierarchicalHeuristic {
+public:
+    HierarchicalHeuristic(const ClusterHierarchy& h, Pos goal)
+        : h_(h), goal_(goal), tables_(h.levels_[0].members.size()),
+          dist_(h.nodes_.size(), kUnreachable), settled_(h.nodes_.size(), 0)
+    {
+        if (!h.grid_.isFree(goal)) return;
+        ClusterHierarchy::Scratch s(h);
+        for (auto& [n, d] : h.connect(1, goal, s)) {
+            dist_[n] = d;
+            open_.push({d, n});
+        }
+    }
+
+    int operator()(Pos p) const {
+        const int c = h_.clusterOf(1, p);
+        std::vector<int>& table = tables_[c];
+        if (table.empty()) fill(c, table);
+        return table[h_.localIndex(c, p)];
+    }
+
+    int clustersFilled() const {
+        return (int)std::count_if(tables_.begin(), tables_.end(),
+                                  [](const std::vector<int>& t) { return !t.empty(); });
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = dist_.capacity() * sizeof(int) + settled_.capacity()
+                     + tables_.capacity() * sizeof(std::vector<int>);
+        for (auto& t : tables_) bytes += t.capacity() * sizeof(int);
+        return bytes;
+    }
+
+private:
+    using Item = std::pair<int, int>;  // (distance, node)
+    const ClusterHierarchy& h_;
+    Pos goal_;
+    mutable std::vector<std::vector<int>> tables_;  // per level-1 cluster, filled on first use
+    mutable std::vector<int> dist_;
+    mutable std::vector<char> settled_;
+    mutable std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open_;
+
+    // Resumes the Dijkstra until n is settled or nothing is left.
+    void settle(int n) const {
+        while (!settled_[n] && !open_.empty()) {
+            auto [d, m] = open_.top();
+            open_.pop();
+            if (settled_[m] || d > dist_[m]) continue;
+            settled_[m] = 1;
+            h_.forEachEdge(1, m, [&](int k, int cost) {
+                if (d + cost < dist_[k]) {
+                    dist_[k] = d + cost;
+                    open_.push({d + cost, k});
+                }
+            });
+        }
+    }
+
+    void fill(int c, std::vector<int>& table) const {
+        ClusterHierarchy::Seeds seeds;
+        for (int n : h_.levels_[0].members[c]) {
+            settle(n);
+            if (settled_[n]) seeds.push_back({h_.nodes_[n].cell, dist_[n]});
+        }
+        if (h_.grid_.isFree(goal_) && h_.clusterOf(1, goal_) == c)
+            seeds.push_back({h_.grid_.cellIndex(goal_), 0});
+        h_.clusterDistances(c, seeds, table);
+    }
+};
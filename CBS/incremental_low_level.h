@@ -0,0 +1,299 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "constraint_table.h"
+#include "heuristic.h"
+#include <queue>
+
+/*
+ * Incremental Space-Time A* (Lifelong Planning A*, Koenig et al. 2004)
+ *
+ * Keeps one agent's search state (g / rhs per space-time state plus the open
+ * list) alive between replans. A CT child adds exactly one constraint, which
+ * removes one space-time vertex or edge. Instead of searching again from
+ * agent.start, the child copies its parent's planner, invalidates the state
+ * the constraint touches and lets LPA* repair only the affected part.
+ *
+ * Same semantics as SpaceTimeAStar::findPath: unit moves including waits,
+ * goal accepted once the table's last vertex constraint there has passed.
+ *
+ * States at t >= horizon are folded into one static layer, which is valid
+ * while every constraint is earlier than the horizon. A constraint at or past
+ * the horizon doubles it and restarts from scratch; this is rare along a
+ * branch because conflicts happen before agents finish their paths.
+ */
+
+class IncrementalSTAStar {
+public:
+    // `heuristic`, if given, is agent.goal's distance table and must outlive
+    // this planner and its copies. `stop` is polled as in SpaceTimeAStar; a
+    // stopped plan or replan leaves path() empty.
+    IncrementalSTAStar(const Grid& grid, const Agent& agent, const ConstraintTable& cons,
+                       const HeuristicTable* heuristic = nullptr, const StopFn& stop = nullptr)
+        : grid_(&grid), agent_(agent), heuristic_(heuristic)
+    {
+        reset(cons, std::max(cons.latestTimestep() + 1, 2 * manhattan(agent.start, agent.goal) + 1), stop);
+    }
+
+    const Path& path() const { return path_; }
+
+    // Number of states popped by the last plan/replan, for comparing with a
+    // fresh search.
+    int lastExpansions() const { return expansions_; }
+
+    // Approximate heap footprint of the search state.
+    size_t memoryBytes() const {
+        return sizeof(*this) + rec_.memoryBytes() + open_.size() * sizeof(QItem)
+             + path_.capacity() * sizeof(Pos);
+    }
+
+    // `cons` must be the agent's table with `added` already in it.
+    const Path& replan(const ConstraintTable& cons, const Constraint& added, const StopFn& stop = nullptr) {
+        return replan(cons, std::vector<Constraint>{added}, stop);
+    }
+
+    const Path& replan(const ConstraintTable& cons, const std::vector<Constraint>& added,
+                       const StopFn& stop = nullptr) {
+        int last = 0;
+        for (auto& c : added) last = std::max({last, c.timestep, c.is_edge ? 0 : c.until});
+        if (last >= horizon_) {
+            reset(cons, std::max(last + 1, 2 * horizon_), stop);
+            return path_;
+        }
+        goal_free_after_ = cons.latestAt(grid_->cellIndex(agent_.goal));
+        for (auto& c : added) {
+            Pos at = c.is_edge ? c.loc2 : c.loc;
+            for (int t = c.timestep; t <= std::max(c.timestep, c.is_edge ? 0 : c.until); t++)
+                updateVertex(cons, grid_->vertexKey(at, t));
+        }
+        updateVertex(cons, kSink);
+        if (computeShortestPath(cons, stop)) extractPath(cons);
+        else path_.clear();
+        return path_;
+    }
+
+private:
+    static constexpr int INF = INT_MAX / 4;
+    // Move field 15 is never produced by stateKey(), so these can't collide.
+    static constexpr StateKey kEmpty = ~(StateKey)0;
+    static constexpr StateKey kSink = ~(StateKey)0 - 1;
+
+    struct Rec { int g = INF, rhs = INF; };
+
+    // Open-addressing StateKey -> Rec table. Copying a planner for a CT child
+    // is then two flat vector copies instead of one allocation per state.
+    class RecTable {
+    public:
+        RecTable() { clear(); }
+        void clear() {
+            keys_.assign(64, kEmpty);
+            vals_.assign(64, Rec{});
+            size_ = 0;
+        }
+        const Rec* find(StateKey k) const {
+            for (size_t i = slot(k);; i = (i + 1) & (keys_.size() - 1)) {
+                if (keys_[i] == k) return &vals_[i];
+                if (keys_[i] == kEmpty) return nullptr;
+            }
+        }
+        Rec& operator[](StateKey k) {
+            if ((size_ + 1) * 2 > keys_.size()) grow();
+            size_t i = slot(k);
+            for (; keys_[i] != kEmpty; i = (i + 1) & (keys_.size() - 1))
+                if (keys_[i] == k) return vals_[i];
+            keys_[i] = k;
+            size_++;
+            return vals_[i] = Rec{};
+        }
+        size_t size() const { return size_; }
+        size_t memoryBytes() const {
+            return keys_.capacity() * sizeof(StateKey) + vals_.capacity() * sizeof(Rec);
+        }
+
+    private:
+        std::vector<StateKey> keys_;
+        std::vector<Rec> vals_;
+        size_t size_ = 0;
+
+        size_t slot(StateKey k) const { return KeyHash()(k) & (keys_.size() - 1); }
+        void grow() {
+            std::vector<StateKey> keys(keys_.size() * 2, kEmpty);
+            std::vector<Rec> vals(keys.size());
+            keys.swap(keys_);
+            vals.swap(vals_);
+            size_ = 0;
+            for (size_t i = 0; i < keys.size(); i++)
+                if (keys[i] != kEmpty) (*this)[keys[i]] = vals[i];
+        }
+    };
+    struct Key {
+        int k1, k2;
+        bool operator<(const Key& o) const { return k1 < o.k1 || (k1 == o.k1 && k2 < o.k2); }
+        bool operator==(const Key& o) const { return k1 == o.k1 && k2 == o.k2; }
+    };
+    struct QItem {
+        Key k;
+        StateKey s;
+        bool operator>(const QItem& o) const { return o.k < k; }
+    };
+
+    const Grid* grid_;
+    Agent agent_;
+    const HeuristicTable* heuristic_;
+    int horizon_ = 1;
+    int goal_free_after_ = -1;
+    StateKey start_ = 0;
+    RecTable rec_;
+    std::priority_queue<QItem, std::vector<QItem>, std::greater<QItem>> open_;
+    Path path_;
+    int expansions_ = 0;
+
+    void reset(const ConstraintTable& cons, int horizon, const StopFn& stop) {
+        horizon_ = std::min(horizon, kMaxTimestep);
+        goal_free_after_ = cons.latestAt(grid_->cellIndex(agent_.goal));
+        rec_.clear();
+        open_ = {};
+        start_ = grid_->vertexKey(agent_.start, 0);
+        rec_[start_].rhs = 0;
+        open_.push({calcKey(start_), start_});
+        if (computeShortestPath(cons, stop)) extractPath(cons);
+        else path_.clear();
+    }
+
+    Rec& at(StateKey s) { return rec_[s]; }
+    Rec get(StateKey s) const {
+        const Rec* r = rec_.find(s);
+        return r ? *r : Rec{};
+    }
+
+    int h(StateKey s) const {
+        if (s == kSink) return 0;
+        if (heuristic_) return std::min((*heuristic_)[keyCell(s)], INF);
+        return manhattan(grid_->cellPos(keyCell(s)), agent_.goal);
+    }
+
+    Key calcKey(StateKey s) const {
+        Rec r = get(s);
+        int m = std::min(r.g, r.rhs);
+        return m >= INF ? Key{INF, INF} : Key{m + h(s), m};
+    }
+
+    bool isGoalState(StateKey s) const {
+        return s != kSink && keyCell(s) == grid_->cellIndex(agent_.goal)
+               && keyTime(s) > goal_free_after_;
+    }
+
+    // Calls fn(pred, cost) for every usable incoming edge.
+    template <typename Fn>
+    void forEachPred(const ConstraintTable& cons, StateKey s, Fn fn) const {
+        if (s == kSink) {
+            int goal = grid_->cellIndex(agent_.goal);
+            for (int t = std::max(goal_free_after_ + 1, 0); t <= horizon_; t++)
+                fn(stateKey(goal, t), 0);
+            return;
+        }
+        int t = keyTime(s);
+        if (t == 0) return;
+        Pos p = grid_->cellPos(keyCell(s));
+        if (cons.blocked(grid_->vertexKey(p, t))) return;
+        grid_->forEachNeighbor(p, [&](Pos q) {
+            if (cons.blocked(grid_->edgeKey(q, p, t))) return;
+            fn(grid_->vertexKey(q, t - 1), 1);
+            if (t == horizon_) fn(grid_->vertexKey(q, t), 1);
+        });
+    }
+
+    template <typename Fn>
+    void forEachSucc(const ConstraintTable& cons, StateKey s, Fn fn) const {
+        int t = keyTime(s);
+        Pos p = grid_->cellPos(keyCell(s));
+        int nt = std::min(t + 1, horizon_);
+        grid_->forEachNeighbor(p, [&](Pos q) {
+            if (t + 1 <= horizon_ && (cons.blocked(grid_->vertexKey(q, t + 1)) ||
+                                      cons.blocked(grid_->edgeKey(p, q, t + 1))))
+                return;
+            fn(grid_->vertexKey(q, nt));
+        });
+        if (isGoalState(s)) fn(kSink);
+    }
+
+    void updateVertex(const ConstraintTable& cons, StateKey s) {
+        if (s != start_) {
+            int best = INF;
+            forEachPred(cons, s, [&](StateKey p, int c) {
+                best = std::min(best, get(p).g + c);
+            });
+            at(s).rhs = std::min(best, INF);
+        }
+        Rec r = get(s);
+        if (r.g != r.rhs) open_.push({calcKey(s), s});
+    }
+
+    // Drops queue entries whose state became consistent or was re-keyed.
+    bool cleanTop() {
+        while (!open_.empty()) {
+            const QItem& top = open_.top();
+            Rec r = get(top.s);
+            if (r.g != r.rhs && calcKey(top.s) == top.k) return true;
+            open_.pop();
+        }
+        return false;
+    }
+
+    // False if `stop` cut it short.
+    bool computeShortestPath(const ConstraintTable& cons, const StopFn& stop) {
+        expansions_ = 0;
+        while (cleanTop()) {
+            if (stop && (expansions_ + 1) % kStopCheckInterval == 0 && stop()) return false;
+            // The sink is reached over 0-cost edges, so goal states can tie
+            // with it; keep going through ties.
+            Rec sink = get(kSink);
+            if (calcKey(kSink) < open_.top().k && sink.rhs == sink.g) break;
+            StateKey u = open_.top().s;
+            open_.pop();
+            expansions_++;
+            Rec& r = at(u);
+            if (r.g > r.rhs) {
+                // g only went down, so a successor's rhs can only improve
+                // through u; no need to rescan all of its predecessors.
+                int g = r.g = r.rhs;
+                forEachSucc(cons, u, [&](StateKey s) {
+                    Rec& rs = at(s);
+                    int via = g + (s == kSink ? 0 : 1);
+                    if (s != start_ && via < rs.rhs) {
+                        rs.rhs = via;
+                        if (rs.g != rs.rhs) open_.push({calcKey(s), s});
+                    }
+                });
+            } else {
+                r.g = INF;
+                forEachSucc(cons, u, [&](StateKey s) { updateVertex(cons, s); });
+                updateVertex(cons, u);
+            }
+        }
+        return true;
+    }
+
+    void extractPath(const ConstraintTable& cons) {
+        path_.clear();
+        int cost = get(kSink).g;
+        if (cost >= INF) return;
+
+        StateKey s = kSink;
+        for (int steps = 0; s != start_ && steps <= cost + 1; steps++) {
+            StateKey best = s;
+            int best_g = INF;
+            forEachPred(cons, s, [&](StateKey p, int c) {
+                int g = get(p).g;
+                if (g + c < best_g || (g + c == best_g && keyTime(p) < keyTime(best))) {
+                    best_g = g + c;
+                    best = p;
+                }
+            });
+            if (best == s) { path_.clear(); return; }
+            s = best;
+            path_.push_back(grid_->cellPos(keyCell(s)));
+        }
+        std::reverse(path_.begin(), path_.end());
+    }
+};
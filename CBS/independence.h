@@ -0,0 +1,154 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "cbs.h"
+#include "conflicts.h"
+#include "solver.h"
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+/*
+ * Independence Detection (Standley, 2010) in front of CBS
+ *
+ * CBS cost grows with the number of agents that really interact, not with k.
+ * ID keeps agents in groups, starting with one group per agent:
+ *   1. Solve every group that has no solution yet, each with its own CBS
+ *      instance on its own thread (agent ids remapped to 0..m-1).
+ *   2. Find all colliding agents across groups. None: the union of the group
+ *      solutions is the answer. Otherwise merge every set of groups linked by
+ *      a collision into one group and go back to 1.
+ *
+ * Groups only grow, so this ends after at most k-1 merges. Since every group
+ * is solved optimally and merged groups are solved jointly, the result has the
+ * same sum of costs as CBS on the whole instance (simple ID).
+ */
+
+class IndependenceDetection : public MAPFSolver {
+public:
+    IndependenceDetection(const Grid& grid, const std::vector<Agent>& agents)
+        : MAPFSolver(grid, agents) {}
+
+    const char* name() const override { return "ID"; }
+
+    // Worker threads; 0 = hardware concurrency.
+    void setThreads(int n) { threads_ = n; }
+
+    // max_nodes is the CT node limit of each group's CBS.
+    bool solve(int max_nodes = 100000) override {
+        begin();
+        const int k = (int)agents_.size();
+
+        group_of_.resize(k);
+        std::iota(group_of_.begin(), group_of_.end(), 0);
+        std::vector<Path> paths(k);
+        std::vector<std::vector<int>> pending(k);
+        for (int a = 0; a < k; a++) pending[a] = {a};
+
+        while (true) {
+            SolveStatus status = solveGroups(pending, paths, max_nodes);
+            if (status != SolveStatus::SOLVED) return finish(status);
+            // Groups are solved optimally and only grow, so the sum of their
+            // costs bounds the joint optimum from below.
+            lower_bound_ = pathsCost(paths);
+            progress();
+
+            // Union-find over groups linked by a collision.
+            std::vector<int> parent(k);
+            std::iota(parent.begin(), parent.end(), 0);
+            auto find = [&](int g) {
+                while (parent[g] != g) g = parent[g] = parent[parent[g]];
+                return g;
+            };
+            bool merged = false;
+            for (auto [a1, a2] : findConflictingPairs(grid_, paths)) {
+                int g1 = find(group_of_[a1]), g2 = find(group_of_[a2]);
+                if (g1 == g2) continue;
+                parent[std::max(g1, g2)] = std::min(g1, g2);
+                merged = true;
+            }
+            if (!merged) break;
+
+            std::vector<char> changed(k, 0);
+            for (int a = 0; a < k; a++) {
+                int g = find(group_of_[a]);
+                if (g != group_of_[a]) changed[g] = changed[group_of_[a]] = 1;
+            }
+            pending.assign(k, {});
+            for (int a = 0; a < k; a++) {
+                bool was_changed = changed[group_of_[a]];
+                group_of_[a] = find(group_of_[a]);
+                if (was_changed) pending[group_of_[a]].push_back(a);
+            }
+        }
+
+        solution_ = std::move(paths);
+        solution_cost_ = pathsCost(solution_);
+        return finish(SolveStatus::SOLVED);
+    }
+
+    // After solve(): number of independent groups and the largest one.
+    int numGroups() const {
+        std::vector<char> seen(group_of_.size(), 0);
+        int n = 0;
+        for (int g : group_of_) if (!seen[g]) { seen[g] = 1; n++; }
+        return n;
+    }
+    int largestGroup() const {
+        std::vector<int> size(group_of_.size(), 0);
+        int best = 0;
+        for (int g : group_of_) best = std::max(best, ++size[g]);
+        return best;
+    }
+
+private:
+    int threads_ = 0;
+    std::vector<int> group_of_;  // agent -> group id (lowest original agent id)
+
+    // Solves each non-empty pending[g] with a fresh CBS, several at a time.
+    // Returns SOLVED or the status of the first group that failed.
+    SolveStatus solveGroups(const std::vector<std::vector<int>>& pending, std::vector<Path>& paths,
+                            int max_nodes) {
+        std::vector<const std::vector<int>*> jobs;
+        for (auto& members : pending)
+            if (!members.empty()) jobs.push_back(&members);
+
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::atomic<SolveStatus> failure{SolveStatus::SOLVED};
+        std::atomic<int> expanded{0}, generated{0};
+        auto worker = [&] {
+            for (size_t j; !failed && (j = next++) < jobs.size();) {
+                const std::vector<int>& members = *jobs[j];
+                std::vector<Agent> sub;
+                for (int a : members)
+                    sub.push_back({(int)sub.size(), agents_[a].start, agents_[a].goal});
+                CBS cbs(grid_, sub);
+                cbs.setParent(this);
+                bool ok = cbs.solve(max_nodes);
+                expanded += cbs.getNodesExpanded();
+                generated += cbs.getNodesGenerated();
+                if (!ok) {
+                    SolveStatus none = SolveStatus::SOLVED;
+                    failure.compare_exchange_strong(none, cbs.getStatus());
+                    failed = true;
+                    return;
+                }
+                // Each job writes only its own agents' paths.
+                for (size_t i = 0; i < members.size(); i++)
+                    paths[members[i]] = cbs.getSolution()[i];
+            }
+        };
+
+        int n = threads_ > 0 ? threads_ : (int)std::max(1u, std::thread::hardware_concurrency());
+        n = std::min(n, (int)jobs.size());
+        std::vector<std::thread> pool;
+        for (int i = 1; i < n; i++) pool.emplace_back(worker);
+        worker();
+        for (auto& t : pool) t.join();
+
+        nodes_expanded_ += expanded;
+        nodes_generated_ += generated;
+        return failure;
+    }
+};
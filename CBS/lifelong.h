@@ -0,0 +1,126 @@
+#pragma once
+#include "cbs.h"
+#include <chrono>
+#include <functional>
+
+/*
+ * Lifelong MAPF — Rolling-Horizon Collision Resolution (Li et al., 2021)
+ *
+ * Agents get a new goal every time they reach one. Every `replan_period`
+ * ticks the planner runs windowed CBS from the current positions to the
+ * current goals, resolving only conflicts in the first `window` timesteps,
+ * and then executes the first `replan_period` moves of that plan. Because
+ * replan_period <= window, every executed move is conflict-free.
+ *
+ * Kept between replans:
+ *   - goal distance tables (HeuristicCache), so a goal seen before costs no
+ *     BFS; capped at two tables per agent, so memory doesn't grow with the
+ *     number of goals handed out
+ *   - the unexecuted rest of each path, reused as a root path while it is
+ *     still a shortest path to the agent's (unchanged) goal
+ *
+ * A replan's cost depends on the window and the node limit, not on how long
+ * the run has been going. If it fails, every agent waits until the next one.
+ */
+
+class LifelongCBS {
+public:
+    // Called when `agent` reaches its goal at cell `at` on tick `tick`;
+    // returns the next goal, which must be a free cell other than `at`.
+    using GoalAssigner = std::function<Pos(int agent, Pos at, int tick)>;
+
+    LifelongCBS(const Grid& grid, std::vector<Agent> agents, int window, int replan_period,
+                GoalAssigner next_goal)
+        : grid_(grid), agents_(std::move(agents)),
+          window_(std::max(window, 1)),
+          period_(std::max(1, std::min(replan_period, window_))),
+          next_goal_(std::move(next_goal)),
+          cache_(grid, 2 * std::max<size_t>(agents_.size(), 1) * HeuristicCache::tableBytes(grid))
+    {
+        for (auto& a : agents_)
+            if (a.start == a.goal) a.goal = next_goal_(a.id, a.start, 0);
+    }
+
+    // CT node limit per replan.
+    void setMaxNodes(int n) { max_nodes_ = n; }
+
+    // Serve goal distance tables from a persistent per-map cache, so a
+    // restarted planner skips the BFS for every goal seen before. The store
+    // writes tables out as they pile up (MapCache::put), but the caller must
+    // flush the last ones, e.g. on shutdown.
+    void setMapCache(MapCache* store) { cache_.setStore(store); }
+
+    // Advances one tick, replanning first when one is due.
+    void step() {
+        if (tick_ % period_ == 0) replan();
+        tick_++;
+        offset_++;
+        for (auto& a : agents_) {
+            a.start = getPos(plan_[a.id], offset_);
+            if (a.start == a.goal) {
+                goals_reached_++;
+                a.goal = next_goal_(a.id, a.start, tick_);
+            }
+        }
+    }
+
+    void run(int ticks) {
+        for (int i = 0; i < ticks; i++) step();
+    }
+
+    int tick() const { return tick_; }
+    // start = current position, goal = current goal.
+    const std::vector<Agent>& agents() const { return agents_; }
+    int goalsReached() const { return goals_reached_; }
+    int replans() const { return replans_; }
+    int failedReplans() const { return failed_replans_; }
+    double lastReplanMs() const { return last_ms_; }
+    double maxReplanMs() const { return max_ms_; }
+    double totalReplanMs() const { return total_ms_; }
+    size_t cachedHeuristics() const { return cache_.size(); }
+
+private:
+    const Grid& grid_;
+    std::vector<Agent> agents_;
+    int window_;
+    int period_;
+    GoalAssigner next_goal_;
+    HeuristicCache cache_;
+    int max_nodes_ = 10000;
+
+    std::vector<Path> plan_;
+    int offset_ = 0;
+    int tick_ = 0;
+    int goals_reached_ = 0;
+    int replans_ = 0;
+    int failed_replans_ = 0;
+    double last_ms_ = 0, max_ms_ = 0, total_ms_ = 0;
+
+    void replan() {
+        auto t0 = std::chrono::steady_clock::now();
+
+        std::vector<Path> previous(agents_.size());
+        for (int a = 0; a < (int)plan_.size(); a++)
+            if (offset_ < (int)plan_[a].size())
+                previous[a].assign(plan_[a].begin() + offset_, plan_[a].end());
+
+        CBS cbs(grid_, agents_);
+        cbs.setConflictWindow(window_);
+        cbs.setHeuristicCache(&cache_);
+        cbs.setInitialPaths(std::move(previous));
+        if (cbs.solve(max_nodes_)) {
+            plan_ = cbs.getSolution();
+        } else {
+            failed_replans_++;
+            plan_.assign(agents_.size(), Path());
+            for (auto& a : agents_) plan_[a.id] = {a.start};
+        }
+        offset_ = 0;
+        replans_++;
+
+        auto t1 = std::chrono::steady_clock::now();
+        last_ms_ = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        max_ms_ = std::max(max_ms_, last_ms_);
+        total_ms_ += last_ms_;
+    }
+};
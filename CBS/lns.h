@@ -0,0 +1,339 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "low_level.h"
+#include "reservation_table.h"
+#include "heuristic.h"
+#include "cbs.h"
+#include "prioritized.h"
+#include "solver.h"
+#include <atomic>
+#include <limits>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+/*
+ * Anytime MAPF-LNS (Li et al., 2021)
+ *
+ * Improves a collision-free solution for as long as it is given time. Each
+ * iteration destroys the paths of a small neighborhood of agents and replans
+ * them against the paths of everyone else, kept fixed in a reservation table.
+ * The new paths replace the old ones only if their sum of costs is lower, so
+ * the current solution is always the best one found.
+ *
+ * Neighborhoods:
+ *   RANDOM:       agents drawn uniformly.
+ *   AGENT:        the most delayed agent (path length minus its distance to
+ *                 goal, skipping recently picked ones) plus agents whose paths
+ *                 cross its path.
+ *   INTERSECTION: agents passing through cells around a random intersection
+ *                 (a cell with 3+ free neighbors), found by BFS from it.
+ *   ADAPTIVE:     one of the three by roulette wheel, weighted by how much
+ *                 each has improved the cost recently (ALNS).
+ *
+ * Replanners:
+ *   PRIORITIZED:  Space-Time A* for each agent in random order.
+ *   CBS:          CBS on the neighborhood alone, with the others reserved.
+ *
+ * run() can be called from a worker thread. bestSolution(), bestCost() and
+ * trace() may be called from any thread while it runs, and stop() ends it
+ * soon, dropping the replan in progress (the low-level searches poll it).
+ *
+ * LNSSolver wraps it as a MAPFSolver for solveAsync: prioritized planning
+ * finds the first solution, then each LNS iteration is one unit of search,
+ * progress events carry the incumbent cost, and cancel() acts as stop().
+ */
+
+class AnytimeLNS {
+public:
+    enum class Neighborhood { RANDOM, AGENT, INTERSECTION, ADAPTIVE };
+    enum class Replanner { PRIORITIZED, CBS };
+
+    struct TracePoint {
+        double ms;  // since the first run()
+        int cost;
+    };
+
+    // `initial` must be a collision-free solution for `agents`.
+    AnytimeLNS(const Grid& grid, const std::vector<Agent>& agents, std::vector<Path> initial,
+               unsigned seed = 0)
+        : grid_(grid), agents_(agents), paths_(std::move(initial)), cache_(grid), rng_(seed)
+    {
+        cost_ = 0;
+        for (auto& p : paths_) cost_ += (int)p.size() - 1;
+        for (auto& a : agents_) heuristics_.push_back(cache_.get(a.goal));
+        for (int i = 0; i < grid.width * grid.height; i++) {
+            Pos p = grid.cellPos(i);
+            if (!grid.isFree(p)) continue;
+            int degree = 0;
+            grid.forEachNeighbor(p, [&](Pos) { degree++; });
+            if (degree - 1 >= 3) intersections_.push_back(i);  // minus the wait move
+        }
+    }
+
+    void setNeighborhoodSize(int n) { neighborhood_size_ = std::max(n, 1); }
+    void setNeighborhood(Neighborhood n) { neighborhood_ = n; }
+    void setReplanner(Replanner r) { replanner_ = r; }
+    void setCBSNodeLimit(int n) { cbs_node_limit_ = n; }
+
+    // Iterates until time_ms has passed, max_iterations are done, or stop().
+    // Returns the best cost.
+    int run(double time_ms, int max_iterations = INT_MAX) {
+        using Clock = std::chrono::steady_clock;
+        auto t0 = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (trace_.empty()) {
+                epoch_ = t0;
+                trace_.push_back({0, cost_});
+            }
+        }
+        stop_ = false;
+        for (int it = 0; it < max_iterations && !stopping(); it++) {
+            if (std::chrono::duration<double, std::milli>(Clock::now() - t0).count() >= time_ms)
+                break;
+            iterate();
+        }
+        return bestCost();
+    }
+
+    void stop() { stop_ = true; }
+
+    // Stop as on stop() once `check` returns true, e.g. when the solver
+    // running this is cancelled.
+    void setStopCheck(StopFn check) { stop_check_ = std::move(check); }
+
+    std::vector<Path> bestSolution() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return paths_;
+    }
+    int bestCost() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cost_;
+    }
+    std::vector<TracePoint> trace() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return trace_;
+    }
+    int iterations() const { return iterations_; }
+
+private:
+    const Grid& grid_;
+    const std::vector<Agent>& agents_;
+    std::vector<Path> paths_;
+    int cost_;
+    HeuristicCache cache_;
+    std::vector<std::shared_ptr<const HeuristicTable>> heuristics_;
+    std::mt19937 rng_;
+    std::vector<int> intersections_;
+
+    int neighborhood_size_ = 8;
+    Neighborhood neighborhood_ = Neighborhood::ADAPTIVE;
+    Replanner replanner_ = Replanner::PRIORITIZED;
+    int cbs_node_limit_ = 1000;
+
+    // ALNS: one weight per destroy heuristic, moved toward each gain.
+    static constexpr double kReaction = 0.01;
+    static constexpr double kMinWeight = 1e-3;
+    double weights_[3] = {1, 1, 1};
+    std::vector<char> tabu_;  // AGENT: recently picked
+
+    std::atomic<bool> stop_{false};
+    StopFn stop_check_;
+    std::atomic<int> iterations_{0};
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point epoch_;
+    std::vector<TracePoint> trace_;
+
+    bool stopping() const { return stop_ || (stop_check_ && stop_check_()); }
+
+    int pathCost(int a) const { return (int)paths_[a].size() - 1; }
+    int delay(int a) const {
+        return pathCost(a) - (*heuristics_[a])[grid_.cellIndex(agents_[a].start)];
+    }
+
+    void iterate() {
+        int kind = (int)neighborhood_;
+        if (neighborhood_ == Neighborhood::ADAPTIVE) {
+            std::discrete_distribution<int> pick(std::begin(weights_), std::end(weights_));
+            kind = pick(rng_);
+        }
+        std::vector<int> group = kind == 0 ? randomNeighborhood()
+                               : kind == 1 ? agentNeighborhood()
+                               : intersectionNeighborhood();
+        iterations_++;
+        if (group.size() < 2) return;
+
+        int old_cost = 0;
+        for (int a : group) old_cost += pathCost(a);
+
+        std::vector<char> in(agents_.size(), 0);
+        for (int a : group) in[a] = 1;
+        ReservationTable reserved;
+        for (int a = 0; a < (int)agents_.size(); a++)
+            if (!in[a]) reserved.reserve(grid_, paths_[a]);
+
+        std::vector<Path> replanned;
+        bool ok = replanner_ == Replanner::CBS ? replanCBS(group, reserved, replanned)
+                                               : replanPrioritized(group, reserved, replanned);
+        int new_cost = 0;
+        for (auto& p : replanned) new_cost += (int)p.size() - 1;
+
+        int gain = ok ? std::max(old_cost - new_cost, 0) : 0;
+        if (neighborhood_ == Neighborhood::ADAPTIVE)
+            weights_[kind] = std::max(kReaction * gain + (1 - kReaction) * weights_[kind], kMinWeight);
+        if (gain == 0) return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < group.size(); i++) paths_[group[i]] = std::move(replanned[i]);
+        cost_ -= gain;
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - epoch_).count();
+        trace_.push_back({ms, cost_});
+    }
+
+    // Each agent in random order, avoiding the fixed agents and those
+    // replanned before it.
+    bool replanPrioritized(const std::vector<int>& group, ReservationTable& reserved,
+                           std::vector<Path>& out) {
+        std::vector<int> order(group.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng_);
+        out.assign(group.size(), Path());
+        for (int i : order) {
+            int a = group[i];
+            out[i] = SpaceTimeAStar::findPath(grid_, agents_[a], reserved, -1, heuristics_[a].get(),
+                                              [this] { return stopping(); });
+            if (out[i].empty()) return false;
+            reserved.reserve(grid_, out[i]);
+        }
+        return true;
+    }
+
+    bool replanCBS(const std::vector<int>& group, const ReservationTable& reserved,
+                   std::vector<Path>& out) {
+        std::vector<Agent> sub;
+        for (int a : group) sub.push_back({(int)sub.size(), agents_[a].start, agents_[a].goal});
+        CBS cbs(grid_, sub);
+        cbs.setHeuristicCache(&cache_);
+        cbs.setReservations(&reserved);
+        cbs.setStopCheck([this] { return stopping(); });
+        if (!cbs.solve(cbs_node_limit_)) return false;
+        out = cbs.getSolution();
+        return true;
+    }
+
+    std::vector<int> randomNeighborhood() {
+        std::vector<int> all(agents_.size());
+        std::iota(all.begin(), all.end(), 0);
+        std::shuffle(all.begin(), all.end(), rng_);
+        all.resize(std::min(all.size(), (size_t)neighborhood_size_));
+        return all;
+    }
+
+    // Agents visiting each cell, at any time.
+    std::vector<std::vector<int>> agentsByCell() const {
+        std::vector<std::vector<int>> by_cell((size_t)grid_.width * grid_.height);
+        for (int a = 0; a < (int)paths_.size(); a++)
+            for (Pos p : paths_[a]) {
+                auto& v = by_cell[grid_.cellIndex(p)];
+                if (v.empty() || v.back() != a) v.push_back(a);
+            }
+        return by_cell;
+    }
+
+    // Adds the agents in `cands` (shuffled) until the group is full.
+    void fill(std::vector<int>& group, std::vector<char>& in, std::vector<int> cands) {
+        std::shuffle(cands.begin(), cands.end(), rng_);
+        for (int a : cands) {
+            if ((int)group.size() >= neighborhood_size_) return;
+            if (!in[a]) { in[a] = 1; group.push_back(a); }
+        }
+    }
+
+    std::vector<int> agentNeighborhood() {
+        const int n = (int)agents_.size();
+        if ((int)tabu_.size() != n) tabu_.assign(n, 0);
+        int worst = -1;
+        for (int pass = 0; pass < 2 && worst < 0; pass++) {
+            for (int a = 0; a < n; a++)
+                if (!tabu_[a] && delay(a) > 0 && (worst < 0 || delay(a) > delay(worst)))
+                    worst = a;
+            if (worst < 0) tabu_.assign(n, 0);
+        }
+        if (worst < 0) return randomNeighborhood();  // nothing is delayed
+        tabu_[worst] = 1;
+
+        auto by_cell = agentsByCell();
+        std::vector<int> group = {worst};
+        std::vector<char> in(n, 0);
+        in[worst] = 1;
+        std::vector<int> cands;
+        for (Pos p : paths_[worst])
+            for (int a : by_cell[grid_.cellIndex(p)]) cands.push_back(a);
+        fill(group, in, cands);
+        return group;
+    }
+
+    std::vector<int> intersectionNeighborhood() {
+        if (intersections_.empty()) return randomNeighborhood();
+        auto by_cell = agentsByCell();
+        std::vector<int> group;
+        std::vector<char> in(agents_.size(), 0);
+        std::vector<char> seen((size_t)grid_.width * grid_.height, 0);
+        std::vector<int> queue = {intersections_[rng_() % intersections_.size()]};
+        seen[queue[0]] = 1;
+        for (size_t head = 0; head < queue.size() && (int)group.size() < neighborhood_size_; head++) {
+            fill(group, in, by_cell[queue[head]]);
+            grid_.forEachNeighbor(grid_.cellPos(queue[head]), [&](Pos q) {
+                int c = grid_.cellIndex(q);
+                if (!seen[c]) { seen[c] = 1; queue.push_back(c); }
+            });
+        }
+        return group;
+    }
+};
+
+class LNSSolver : public MAPFSolver {
+public:
+    LNSSolver(const Grid& grid, const std::vector<Agent>& agents, unsigned seed = 0)
+        : MAPFSolver(grid, agents), seed_(seed) {}
+
+    const char* name() const override { return "LNS"; }
+
+    // Stop improving after this long (default: only max_nodes and cancel()).
+    void setTimeLimit(double ms) { time_ms_ = ms; }
+
+    // Runs up to max_nodes LNS iterations. Once the first solution exists,
+    // cancel() ends the solve with the best one found and status SOLVED.
+    bool solve(int max_nodes = 100000) override {
+        begin();
+        PrioritizedPlanning pp(grid_, agents_, seed_);
+        pp.setParent(this);
+        if (!pp.solve()) return finish(stopRequested() ? SolveStatus::CANCELLED : pp.getStatus());
+        lower_bound_ = pp.getLowerBound();
+        incumbent_cost_ = pp.getSolutionCost();
+
+        using Clock = std::chrono::steady_clock;
+        const auto t0 = Clock::now();
+        AnytimeLNS lns(grid_, agents_, pp.getSolution(), seed_);
+        lns.setStopCheck(stopFn());
+        while (nodes_expanded_ < max_nodes && !stopRequested()
+               && std::chrono::duration<double, std::milli>(Clock::now() - t0).count() < time_ms_) {
+            lns.run(time_ms_, 1);
+            nodes_expanded_++;
+            nodes_generated_++;
+            incumbent_cost_ = lns.bestCost();
+            progress();
+        }
+        solution_ = lns.bestSolution();
+        solution_cost_ = lns.bestCost();
+        return finish(SolveStatus::SOLVED);
+    }
+
+private:
+    unsigned seed_;
+    double time_ms_ = std::numeric_limits<double>::infinity();
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include "common.h"
 #include "grid.h"
+#include "constraint_table.h"
+#include "heuristic.h"
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -9,10 +11,14 @@
  * Space-Time A*
  *
  * Plans a single agent's path on a grid, respecting a set of constraints.
- * Search state = (position, timestep). Heuristic = Manhattan distance.
+ * Search state = (position, timestep). Heuristic = Manhattan distance, or a
+ * goal distance table (heuristic.h) when the caller has one.
  *
  * Vertex constraint: agent can't be at loc at timestep.
  * Edge constraint: agent can't move from loc to loc2 at timestep.
+ *
+ * States, constraints and the visited tables are all keyed by the 64-bit
+ * StateKey from common.h, so map size and horizon don't collide.
  */
 
 struct STNode {
@@ -24,72 +30,109 @@ struct STNode {
     }
 };
 
-struct StateHash {
-    size_t operator()(const std::pair<Pos,int>& s) const {
-        auto h = PosHash()(s.first);
-        return h ^ (std::hash<int>()(s.second) << 1);
-    }
-};
-struct StateEq {
-    bool operator()(const std::pair<Pos,int>& a, const std::pair<Pos,int>& b) const {
-        return a.first == b.first && a.second == b.second;
-    }
-};
-
-using State = std::pair<Pos,int>;
-
 class SpaceTimeAStar {
 public:
+    // max_time < 0 picks a horizon from the map: at least 200, and never
+    // shorter than one visit to every cell.
     static Path findPath(const Grid& grid, const Agent& agent,
                          const std::vector<Constraint>& constraints,
-                         int max_time = 200)
+                         int max_time = -1,
+                         const HeuristicTable* heuristic = nullptr,
+                         const StopFn& stop = nullptr)
     {
-        std::unordered_set<State, StateHash, StateEq> vertex_cons;
-        std::unordered_set<long long> edge_cons;
-
-        for (auto& c : constraints) {
-            if (c.agent != agent.id) continue;
-            if (!c.is_edge) {
-                vertex_cons.insert({c.loc, c.timestep});
-            } else {
-                edge_cons.insert(encodeEdge(c.loc, c.loc2, c.timestep));
-            }
-        }
+        ConstraintTable table;
+        for (auto& c : constraints)
+            if (c.agent == agent.id) table.add(grid, c);
+        return findPath(grid, agent, table, max_time, heuristic, stop);
+    }
+
+    /*
+     * After the table's latest timestep T the grid is static, so all states
+     * (pos, t > T) are folded into (pos, T+1). The search space is then
+     * finite even when the goal is unreachable. The goal only counts once
+     * no later vertex constraint there could push the agent off it.
+     *
+     * `heuristic`, if given, must be the distance table for agent.goal.
+     *
+     * Table is a ConstraintTable or a ReservationTable (reservation_table.h):
+     * anything with blocked(StateKey), latestTimestep() and latestAt(cell).
+     *
+     * `stop`, if given, is polled every kStopCheckInterval expansions; the
+     * search returns no path once it is true.
+     */
+    template <typename Table>
+    static Path findPath(const Grid& grid, const Agent& agent,
+                         const Table& constraints,
+                         int max_time = -1,
+                         const HeuristicTable* heuristic = nullptr,
+                         const StopFn& stop = nullptr)
+    {
+        if (heuristic)
+            return findPathWith(grid, agent, constraints, max_time,
+                                [&](Pos p) { return (*heuristic)[grid.cellIndex(p)]; }, stop);
+        return findPathWith(grid, agent, constraints, max_time,
+                            [&](Pos p) { return manhattan(p, agent.goal); }, stop);
+    }
+
+    // Same search with any goal distance hval(Pos) -> int that is
+    // kUnreachable exactly where the goal can't be reached. Paths are
+    // shortest when it is admissible; an estimate such as the
+    // HierarchicalHeuristic of hpa.h still gives valid, maybe longer, paths.
+    template <typename Table, typename Heuristic>
+    static Path findPathWith(const Grid& grid, const Agent& agent,
+                             const Table& constraints, int max_time,
+                             const Heuristic& hval, const StopFn& stop = nullptr)
+    {
+        if (max_time < 0)
+            max_time = std::max(200, grid.width * grid.height);
+        max_time = std::min(max_time, kMaxTimestep);
+
+        const int last_t = constraints.latestTimestep();
+        const int goal_free_after = constraints.latestAt(grid.cellIndex(agent.goal));
+        auto fold = [&](int t) { return std::min(t, last_t + 1); };
+        if (hval(agent.start) >= kUnreachable) return {};
+        if (goal_free_after >= max_time) return {};  // e.g. another agent parks there
 
         // A* search
         std::priority_queue<STNode, std::vector<STNode>, std::greater<STNode>> open;
-        std::unordered_map<State, int, StateHash, StateEq> best_g;
-        std::unordered_map<State, State, StateHash, StateEq> came_from;
+        std::unordered_map<StateKey, int, KeyHash> best_g;
+        std::unordered_map<StateKey, StateKey, KeyHash> came_from;
 
-        State start_state = {agent.start, 0};
-        open.push({agent.start, 0, 0, manhattan(agent.start, agent.goal)});
+        StateKey start_state = grid.vertexKey(agent.start, fold(0));
+        open.push({agent.start, 0, 0, hval(agent.start)});
         best_g[start_state] = 0;
 
+        int popped = 0;
         while (!open.empty()) {
+            if (stop && ++popped % kStopCheckInterval == 0 && stop()) return {};
             auto curr = open.top(); open.pop();
-            State curr_state = {curr.pos, curr.t};
+            StateKey curr_state = grid.vertexKey(curr.pos, fold(curr.t));
 
-            if (curr.pos == agent.goal) {
-                return reconstructPath(came_from, curr_state);
+            if (curr.pos == agent.goal && curr.t > goal_free_after) {
+                return reconstructPath(grid, came_from, curr_state);
             }
 
             if (curr.t >= max_time) continue;
 
-            if (best_g.count(curr_state) && curr.g > best_g[curr_state])
+            auto it = best_g.find(curr_state);
+            if (it != best_g.end() && curr.g > it->second)
                 continue;
 
             for (auto& next_pos : grid.getNeighbors(curr.pos)) {
                 int next_t = curr.t + 1;
-                State next_state = {next_pos, next_t};
+                StateKey next_state = grid.vertexKey(next_pos, fold(next_t));
+
+                if (constraints.blocked(grid.vertexKey(next_pos, next_t))) continue;
 
-                if (vertex_cons.count(next_state)) continue;
+                if (constraints.blocked(grid.edgeKey(curr.pos, next_pos, next_t))) continue;
 
-                if (edge_cons.count(encodeEdge(curr.pos, next_pos, next_t))) continue;
+                int h = hval(next_pos);
+                if (h >= kUnreachable) continue;
 
                 int next_g = curr.g + 1;
-                if (!best_g.count(next_state) || next_g < best_g[next_state]) {
-                    best_g[next_state] = next_g;
-                    int h = manhattan(next_pos, agent.goal);
+                auto [bit, fresh] = best_g.try_emplace(next_state, next_g);
+                if (fresh || next_g < bit->second) {
+                    bit->second = next_g;
                     open.push({next_pos, next_t, next_g, next_g + h});
                     came_from[next_state] = curr_state;
                 }
@@ -100,27 +143,20 @@ public:
     }
 
 private:
-    static long long encodeEdge(Pos from, Pos to, int t) {
-  
-        long long key = (long long)from.x;
-        key = key * 1000 + from.y;
-        key = key * 1000 + to.x;
-        key = key * 1000 + to.y;
-        key = key * 100000 + t;
-        return key;
-    }
-
     static Path reconstructPath(
-        const std::unordered_map<State, State, StateHash, StateEq>& came_from,
-        State goal_state)
+        const Grid& grid,
+        const std::unordered_map<StateKey, StateKey, KeyHash>& came_from,
+        StateKey goal_state)
     {
         Path path;
-        State s = goal_state;
-        while (came_from.count(s)) {
-            path.push_back(s.first);
-            s = came_from.at(s);
+        StateKey s = goal_state;
+        auto it = came_from.find(s);
+        while (it != came_from.end()) {
+            path.push_back(grid.cellPos(keyCell(s)));
+            s = it->second;
+            it = came_from.find(s);
         }
-        path.push_back(s.first); 
+        path.push_back(grid.cellPos(keyCell(s))); 
         std::reverse(path.begin(), path.end());
         return path;
     }
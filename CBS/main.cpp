@@ -1,5 +1,14 @@
 #include "cbs.h"
+#include "async_solve.h"
+#include "bitgrid.h"
+#include "lifelong.h"
+#include "lns.h"
+#include "pbs.h"
+#include "prioritized.h"
 #include <chrono>
+#include <mutex>
+#include <random>
+#include <tuple>
 
 /*
  * TEST CBS Demo
@@ -161,6 +170,391 @@ void testMultiAgent() {
     std::cout << "\n";
 }
 
+void testLargeMap() {
+    std::cout << "=== Test 4: Two agents crossing on a 2048x2048 grid ===\n";
+    // Coordinates past 1000 and paths longer than 200 steps: both used to
+    // collide in the old base-1000 edge keys / fixed horizon.
+    Grid grid(2048, 2048);
+
+    // Both agents reach (1024,1500) at t=924.
+    std::vector<Agent> agents = {
+        {0, {100, 1500}, {1900, 1500}},
+        {1, {1024, 576}, {1024, 2000}},
+    };
+
+    CBS cbs(grid, agents);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    bool solved = cbs.solve();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    if (solved) {
+        std::cout << "  Solved! Cost=" << cbs.getSolutionCost()
+                  << " Expanded=" << cbs.getNodesExpanded()
+                  << " Generated=" << cbs.getNodesGenerated()
+                  << " Time=" << ms << "ms\n";
+        for (auto& a : agents) {
+            auto& p = cbs.getSolution()[a.id];
+            std::cout << "  Agent " << a.id << " (" << p.size() - 1 << " steps): ("
+                      << p.front().x << "," << p.front().y << ") -> ("
+                      << p.back().x << "," << p.back().y << ")\n";
+        }
+    } else {
+        std::cout << "  No solution found.\n";
+    }
+    std::cout << "\n";
+}
+
+void testLifelong() {
+    std::cout << "=== Test 5: Lifelong MAPF, 10 agents on 16x16 for 200 ticks ===\n";
+    // New random goal on every arrival; window 10, replan every 5 ticks.
+    Grid grid(16, 16);
+    for (int y = 3; y < 13; y++) { grid.setObstacle(5, y); grid.setObstacle(10, y); }
+
+    std::vector<Pos> free_cells;
+    for (int y = 0; y < grid.height; y++)
+        for (int x = 0; x < grid.width; x++)
+            if (grid.isFree({x, y})) free_cells.push_back({x, y});
+
+    std::mt19937 rng(7);
+    auto random_cell = [&] { return free_cells[rng() % free_cells.size()]; };
+    std::vector<Agent> agents;
+    for (int i = 0; i < 10; i++)
+        agents.push_back({i, {i, 0}, random_cell()});
+
+    LifelongCBS planner(grid, agents, 10, 5, [&](int, Pos at, int) {
+        Pos g = random_cell();
+        while (g == at) g = random_cell();
+        return g;
+    });
+    planner.run(200);
+
+    std::cout << "  Goals reached=" << planner.goalsReached()
+              << " Replans=" << planner.replans()
+              << " Failed=" << planner.failedReplans()
+              << " Cached tables=" << planner.cachedHeuristics() << "\n";
+    std::cout << "  Replan time avg=" << planner.totalReplanMs() / planner.replans()
+              << "ms max=" << planner.maxReplanMs() << "ms\n\n";
+}
+
+void testLNS() {
+    std::cout << "=== Test 6: Anytime LNS on a prioritized solution, 60 agents on 24x24 ===\n";
+    Grid grid(24, 24);
+    for (int x = 2; x < 22; x += 4)
+        for (int y = 2; y < 22; y++)
+            if (y % 6 != 0) grid.setObstacle(x, y);
+
+    std::vector<Pos> free_cells;
+    for (int y = 0; y < grid.height; y++)
+        for (int x = 0; x < grid.width; x++)
+            if (grid.isFree({x, y})) free_cells.push_back({x, y});
+    std::mt19937 rng(11);
+    std::shuffle(free_cells.begin(), free_cells.end(), rng);
+    std::vector<Agent> agents;
+    for (int i = 0; i < 60; i++)
+        agents.push_back({i, free_cells[i], free_cells[60 + i]});
+
+    PrioritizedPlanning pp(grid, agents);
+    if (!pp.solve(100)) {
+        std::cout << "  No initial solution found.\n\n";
+        return;
+    }
+    AnytimeLNS lns(grid, agents, pp.getSolution());
+    lns.run(200);
+
+    std::cout << "  Initial cost=" << pp.getSolutionCost()
+              << " Best cost=" << lns.bestCost()
+              << " Iterations=" << lns.iterations() << "\n";
+    std::cout << "  Cost over time:";
+    for (auto& point : lns.trace())
+        std::cout << " " << (int)point.ms << "ms:" << point.cost;
+    std::cout << "\n\n";
+}
+
+void testSymmetry() {
+    std::cout << "=== Test 7: Rectangle and corridor symmetry reasoning ===\n";
+    // Crossing agents in open space: every pair of shortest paths collides.
+    Grid open(16, 16);
+    std::vector<Agent> crossing = {{0, {0, 4}, {15, 9}}, {1, {4, 0}, {9, 15}}};
+    // Two rooms joined by a corridor, with a long way around below it.
+    Grid rooms(14, 9);
+    for (int y = 0; y < 9; y++)
+        for (int x = 3; x < 11; x++)
+            if (y != 4 && y != 8) rooms.setObstacle(x, y);
+    std::vector<Agent> passing = {{0, {1, 4}, {12, 4}}, {1, {12, 3}, {1, 3}}};
+
+    for (auto [name, grid, agents] : {std::tuple{"rectangle", &open, &crossing},
+                                      std::tuple{"corridor", &rooms, &passing}}) {
+        for (bool symmetry : {false, true}) {
+            CBS cbs(*grid, *agents);
+            cbs.setSymmetryReasoning(symmetry);
+            bool ok = cbs.solve(5000);
+            std::cout << "  " << name << (symmetry ? " with" : " without") << " symmetry reasoning: ";
+            if (ok)
+                std::cout << "cost=" << cbs.getSolutionCost();
+            else
+                std::cout << "not solved";
+            std::cout << " expanded=" << cbs.getNodesExpanded() << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+const char* statusName(SolveStatus status) {
+    switch (status) {
+    case SolveStatus::NOT_STARTED: return "not started";
+    case SolveStatus::SOLVED: return "solved";
+    case SolveStatus::SOLVED_SUBOPTIMAL: return "solved, maybe suboptimal";
+    case SolveStatus::NO_PATH: return "no path";
+    case SolveStatus::NO_SOLUTION: return "no solution";
+    case SolveStatus::NODE_LIMIT: return "node limit";
+    case SolveStatus::MEMORY_LIMIT: return "memory limit";
+    case SolveStatus::CANCELLED: return "cancelled";
+    }
+    return "?";
+}
+
+void testAsync() {
+    std::cout << "=== Test 8: Concurrent async solves with progress and cancellation ===\n";
+    Grid grid(16, 16);
+    std::vector<Agent> easy = {{0, {0, 0}, {15, 15}}, {1, {15, 0}, {0, 15}}, {2, {7, 0}, {7, 15}}};
+    std::vector<Agent> crossing = {{0, {0, 4}, {15, 9}}, {1, {4, 0}, {9, 15}}};
+
+    std::mutex mutex;
+    int best_bound = -1;
+    auto on_progress = [&](const SolveProgress& p) {
+        std::lock_guard<std::mutex> lock(mutex);
+        best_bound = std::max(best_bound, p.lower_bound);
+    };
+    Executor executor = newThreadExecutor();
+    SolveHandle quick = solveAsync(std::make_unique<CBS>(grid, easy), executor);
+    SolveHandle stuck = solveAsync(std::make_unique<CBS>(grid, crossing), executor, INT_MAX, on_progress, 100);
+    SolveHandle pbs = solveAsync(std::make_unique<PBS>(grid, crossing), executor);
+
+    SolveResult r = quick.get();
+    std::cout << "  CBS, 3 agents: cost=" << r.cost << " expanded=" << r.nodes_expanded << "\n";
+    r = pbs.get();
+    std::cout << "  PBS, crossing: cost=" << r.cost << "\n";
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stuck.cancel();
+    r = stuck.get();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::cout << "  CBS, crossing: " << (r.status == SolveStatus::CANCELLED ? "cancelled" : "finished")
+                  << " with lower bound " << best_bound << "\n";
+    }
+
+    // Agent 0 parks in the only gap of a wall, so agent 1's first search
+    // explores every cell on its side until agent 0 arrives (seconds); the
+    // low level polls the stop flag, so cancel() needn't wait for it.
+    Grid walled(200, 200);
+    for (int y = 1; y < 200; y++) walled.setObstacle(100, y);
+    std::vector<Agent> blocked = {{0, {101, 199}, {100, 0}}, {1, {0, 199}, {199, 0}}};
+    auto pp = std::make_unique<PrioritizedPlanning>(walled, blocked);
+    pp->setPriorityOrder({0, 1});
+    SolveHandle slow = solveAsync(std::move(pp), executor);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto t0 = std::chrono::steady_clock::now();
+    slow.cancel();
+    r = slow.get();
+    std::cout << "  PP, agent behind a parked one: " << statusName(r.status) << " "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count()
+              << " ms after cancel()\n";
+
+    // Anytime LNS streams its incumbent; cancelling keeps the best solution.
+    Grid warehouse(24, 24);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 60; i++) warehouse.setObstacle(rng() % 24, rng() % 24);
+    std::vector<Agent> many;
+    std::vector<char> used(24 * 24 * 2, 0);
+    while (many.size() < 40) {
+        Pos s{(int)(rng() % 24), (int)(rng() % 24)}, g{(int)(rng() % 24), (int)(rng() % 24)};
+        int si = warehouse.cellIndex(s), gi = warehouse.cellIndex(g) + 24 * 24;
+        if (!warehouse.isFree(s) || !warehouse.isFree(g) || used[si] || used[gi]) continue;
+        used[si] = used[gi] = 1;
+        many.push_back({(int)many.size(), s, g});
+    }
+    std::vector<int> incumbents;
+    auto on_incumbent = [&](const SolveProgress& p) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (p.incumbent_cost >= 0 && (incumbents.empty() || p.incumbent_cost != incumbents.back()))
+            incumbents.push_back(p.incumbent_cost);
+    };
+    SolveHandle lns = solveAsync(std::make_unique<LNSSolver>(warehouse, many), executor, INT_MAX,
+                                 on_incumbent, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    lns.cancel();
+    r = lns.get();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << "  LNS, 40 agents: " << (isSolved(r.status) ? "solved" : "not solved")
+              << " cost=" << r.cost << " after " << r.nodes_expanded << " iterations; incumbents:";
+    for (int c : incumbents) std::cout << " " << c;
+    std::cout << "\n\n";
+}
+
+void testHierarchy() {
+    std::cout << "=== Test 9: Hierarchical abstraction (HPA*) on a 1024x1024 grid ===\n";
+    using Clock = std::chrono::high_resolution_clock;
+    auto ms = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    Grid grid(1024, 1024);
+    std::mt19937 rng(3);
+    for (int i = 0; i < 3000; i++) {
+        int x = rng() % 1000, y = rng() % 1000, w = 2 + rng() % 20, h = 2 + rng() % 20;
+        for (int yy = y; yy < std::min(y + h, 1024); yy++)
+            for (int xx = x; xx < std::min(x + w, 1024); xx++) grid.setObstacle(xx, yy);
+    }
+    Agent agent{0, {5, 5}, {1000, 1010}};
+    grid.obstacles[grid.cellIndex(agent.start)] = grid.obstacles[grid.cellIndex(agent.goal)] = false;
+
+    auto t0 = Clock::now();
+    ClusterHierarchy hierarchy(grid, 16, 3);
+    auto t1 = Clock::now();
+    std::cout << "  Built in " << ms(t0, t1) << "ms\n";
+    for (int l = 0; l <= hierarchy.levels(); l++) {
+        auto s = hierarchy.stats(l);
+        std::cout << "  Level " << l << ": " << s.clusters << " clusters of " << s.cluster_size << "x"
+                  << s.cluster_size << ", " << s.nodes << " nodes, " << s.edges << " edges, "
+                  << s.bytes / 1024 << " KiB\n";
+    }
+
+    t0 = Clock::now();
+    HPAPath plan = hierarchy.plan(agent.start, agent.goal);
+    plan.at(100);
+    t1 = Clock::now();
+    Path full = plan.full();
+    auto t2 = Clock::now();
+    HeuristicTable exact = computeDistanceTable(grid, agent.goal);
+    std::cout << "  Plan: first 100 steps in " << ms(t0, t1) << "ms, all " << full.size() - 1
+              << " in " << ms(t0, t2) << "ms (optimal " << exact[grid.cellIndex(agent.start)] << ")\n";
+
+    ConstraintTable none;
+    t0 = Clock::now();
+    Path manhattan_path = SpaceTimeAStar::findPath(grid, agent, none);
+    t1 = Clock::now();
+    HierarchicalHeuristic estimate(hierarchy, agent.goal);
+    Path guided = SpaceTimeAStar::findPathWith(grid, agent, none, -1, estimate);
+    t2 = Clock::now();
+    std::cout << "  Space-time A*: Manhattan " << ms(t0, t1) << "ms, hierarchical " << ms(t1, t2)
+              << "ms (" << guided.size() - 1 << " steps, " << estimate.clustersFilled() << " of "
+              << hierarchy.stats(1).clusters << " clusters filled, " << estimate.memoryBytes() / 1024
+              << " KiB)\n";
+
+    std::vector<Agent> agents;
+    for (int i = 0; (int)agents.size() < 20; i++) {
+        Pos s{(int)(rng() % 1024), (int)(rng() % 1024)}, g{(int)(rng() % 1024), (int)(rng() % 1024)};
+        if (grid.isFree(s) && grid.isFree(g) && exact[grid.cellIndex(s)] < kUnreachable
+            && exact[grid.cellIndex(g)] < kUnreachable)
+            agents.push_back({(int)agents.size(), s, g});
+    }
+    PrioritizedPlanning pp(grid, agents);
+    pp.setHierarchy(&hierarchy);
+    t0 = Clock::now();
+    bool solved = pp.solve();
+    t1 = Clock::now();
+    std::cout << "  PP with the hierarchy, 20 agents: "
+              << (solved ? "cost=" + std::to_string(pp.getSolutionCost()) : std::string("no solution"))
+              << " in " << ms(t0, t1) << "ms\n\n";
+}
+
+void testIncremental() {
+    std::cout << "=== Test 10: Incremental low level vs plain CBS on Tests 1-3 and 7 ===\n";
+    Grid corridor(5, 3);
+    for (int x = 0; x < 5; x++) {
+        if (x != 2) corridor.setObstacle(x, 0);
+        corridor.setObstacle(x, 2);
+    }
+    Grid open5(5, 5);
+    Grid walls(8, 8);
+    for (auto [x, y] : {std::pair{2, 1}, {2, 2}, {2, 3}, {5, 4}, {5, 5}, {5, 6}, {3, 5}})
+        walls.setObstacle(x, y);
+    Grid open16(16, 16);
+    Grid rooms(14, 9);
+    for (int y = 0; y < 9; y++)
+        for (int x = 3; x < 11; x++)
+            if (y != 4 && y != 8) rooms.setObstacle(x, y);
+
+    std::vector<std::tuple<const char*, const Grid*, std::vector<Agent>>> instances = {
+        {"swap", &corridor, {{0, {0, 1}, {4, 1}}, {1, {4, 1}, {0, 1}}}},
+        {"cross", &open5, {{0, {0, 2}, {4, 2}}, {1, {2, 0}, {2, 4}}}},
+        {"four agents", &walls, {{0, {0, 0}, {7, 7}}, {1, {7, 0}, {0, 7}}, {2, {0, 7}, {7, 0}}, {3, {7, 7}, {0, 0}}}},
+        {"rectangle", &open16, {{0, {0, 4}, {15, 9}}, {1, {4, 0}, {9, 15}}}},
+        {"corridor", &rooms, {{0, {1, 4}, {12, 4}}, {1, {12, 3}, {1, 3}}}},
+    };
+    for (auto& [name, grid, agents] : instances) {
+        int cost[2];
+        for (bool incremental : {false, true}) {
+            CBS cbs(*grid, agents);
+            // The rectangle instance is only solvable in time with symmetry
+            // reasoning; the others run plain CBS, with more replanning.
+            cbs.setSymmetryReasoning(grid == &open16);
+            cbs.setIncrementalLowLevel(incremental);
+            cost[incremental] = cbs.solve(5000) ? cbs.getSolutionCost() : -1;
+        }
+        std::cout << "  " << name << ": plain cost=" << cost[0] << " incremental cost=" << cost[1]
+                  << (cost[0] == cost[1] ? "" : "  MISMATCH") << "\n";
+    }
+    std::cout << "\n";
+}
+
+void testMemoryBudget() {
+    std::cout << "=== Test 11: CBS under a memory budget (Test 7 corridor, no symmetry reasoning) ===\n";
+    Grid rooms(14, 9);
+    for (int y = 0; y < 9; y++)
+        for (int x = 3; x < 11; x++)
+            if (y != 4 && y != 8) rooms.setObstacle(x, y);
+    std::vector<Agent> passing = {{0, {1, 4}, {12, 4}}, {1, {12, 3}, {1, 3}}};
+
+    CBS unlimited(rooms, passing);
+    unlimited.solve(5000);
+    std::cout << "  no budget: " << statusName(unlimited.getStatus()) << " cost=" << unlimited.getSolutionCost()
+              << " peak=" << unlimited.getPeakMemory() << " bytes\n";
+
+    using Policy = CBS::MemoryPolicy;
+    // Under a tight budget DROP_WORST drops nodes cheaper than its solution,
+    // so it can no longer prove it optimal (or may miss the optimum).
+    for (size_t budget : {unlimited.getPeakMemory() / 4, unlimited.getPeakMemory() / 40}) {
+        for (auto [name, policy] : {std::pair{"drop worst", Policy::DROP_WORST}, std::pair{"stop", Policy::STOP}}) {
+            CBS cbs(rooms, passing);
+            cbs.setMemoryBudget(budget, policy);
+            cbs.solve(5000);
+            std::cout << "  budget " << budget << " bytes, " << name << ": " << statusName(cbs.getStatus());
+            if (isSolved(cbs.getStatus()))
+                std::cout << " cost=" << cbs.getSolutionCost() << " lower bound=" << cbs.getLowerBound();
+            std::cout << " peak=" << cbs.getPeakMemory() << " dropped=" << cbs.getNodesDropped() << "\n";
+        }
+    }
+    std::cout << "\n";
+}
+
+void testBitGrid() {
+    std::cout << "=== Test 12: BitGrid components against the scalar BFS ===\n";
+    // Odd width, so rows end partway through a word.
+    Grid grid(301, 157);
+    std::mt19937 rng(12);
+    for (int i = 0; i < grid.width * grid.height; i++)
+        if (rng() % 100 < 30) grid.obstacles[i] = true;
+    Components components = connectedComponents(BitGrid(grid));
+
+    int connectivity_mismatches = 0;
+    // One BFS per component, from each free cell no earlier BFS reached; it
+    // must reach exactly the cells labeled like its source.
+    std::vector<char> reached(grid.obstacles.size(), 0);
+    int scalar_components = 0;
+    for (int cell = 0; cell < grid.width * grid.height; cell++) {
+        if (grid.obstacles[cell] || reached[cell]) continue;
+        HeuristicTable scalar = computeDistanceTable(grid, grid.cellPos(cell));
+        scalar_components++;
+        for (int other = 0; other < grid.width * grid.height; other++) {
+            if (scalar[other] < kUnreachable) reached[other] = 1;
+            if ((scalar[other] < kUnreachable) != components.connected(cell, other)) connectivity_mismatches++;
+        }
+    }
+    std::cout << "  " << components.count << " components (" << scalar_components << " by BFS), "
+              << connectivity_mismatches << " cells with the wrong connectivity\n\n";
+}
+
 int main() {
     std::cout << "Simple CBS (Conflict-Based Search) for MAPF\n";
     std::cout << "=============================================\n\n";
@@ -168,6 +562,15 @@ int main() {
     testSwap();
     testCross();
     testMultiAgent();
+    testLargeMap();
+    testLifelong();
+    testLNS();
+    testSymmetry();
+    testAsync();
+    testHierarchy();
+    testIncremental();
+    testMemoryBudget();
+    testBitGrid();
 
     return 0;
 }
\ No newline at end of file
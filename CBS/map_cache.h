@@ -0,0 +1,295 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Persistent per-map cache
+ *
+ * Preprocessing results for one grid, kept in a binary file so a restarted
+ * planner gets them back without recomputing: goal distance tables (through
+ * HeuristicCache::setStore) and the connected component labeling
+ * (cachedComponents). Corridor chains for symmetry reasoning are not stored;
+ * each is a short local walk from the conflict cell. The file is tied to the grid
+ * by a hash of its contents; a file written for another map, or a damaged
+ * one, is ignored and replaced on the next flush().
+ *
+ * Layout (native byte order, 8-byte aligned):
+ *   header:   magic "MAPFCACH", version, width, height, section count, grid hash
+ *   sections: tag, key, payload size, payload (padded to 8 bytes)
+ *
+ * On POSIX the file is memory-mapped read-only, so opening it costs no
+ * reads: find() points straight into the mapping and pages load on first
+ * touch. Elsewhere (_WIN32) the file is read into memory instead.
+ *
+ * New sections go to a pending buffer. flush() appends them to the file and
+ * then bumps the section count in the header, so an interrupted flush leaves
+ * the old sections readable; a replaced section is simply appended again
+ * (the last copy wins). Only when there is no valid file, or replaced copies
+ * make up half of it, does flush() write everything to a temporary file and
+ * rename it over the old one. Either way the result is mapped again.
+ *
+ * put() flushes by itself once the pending buffer passes its cap, so a
+ * long-running caller (e.g. a lifelong planner) holds at most that much
+ * besides the mapping, which the OS can page out. What is still pending is
+ * lost unless the caller flushes before exiting. Not thread-safe.
+ */
+
+class MapCache {
+public:
+    enum Tag : uint32_t {
+        DISTANCE_TABLE = 1,  // key: goal cell; payload: int32 per cell (heuristic.h)
+        COMPONENTS = 2,      // key: 0; payload: int32 count, then int32 label per cell (bitgrid.h)
+    };
+
+    static constexpr size_t kDefaultPendingBytes = size_t(64) << 20;
+
+    MapCache(const Grid& grid, std::string path, size_t max_pending_bytes = kDefaultPendingBytes)
+        : path_(std::move(path)), width_(grid.width), height_(grid.height), hash_(hashGrid(grid)),
+          max_pending_bytes_(max_pending_bytes)
+    {
+        map();
+    }
+    ~MapCache() { unmap(); }
+    MapCache(const MapCache&) = delete;
+    MapCache& operator=(const MapCache&) = delete;
+
+    // FNV-1a over the dimensions and obstacle layout.
+    static uint64_t hashGrid(const Grid& grid) {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+        mix((uint64_t)grid.width);
+        mix((uint64_t)grid.height);
+        for (bool blocked : grid.obstacles) mix(blocked);
+        return h;
+    }
+
+    // True if an existing file for this grid was opened.
+    bool loaded() const { return data_ != nullptr; }
+    size_t sections() const {
+        size_t n = pending_.size();
+        for (auto& [id, s] : index_) n += !pending_.count(id);
+        return n;
+    }
+
+    // Payload of a section and its size, or {nullptr, 0}. Valid until the
+    // next put() or flush().
+    std::pair<const void*, size_t> find(uint32_t tag, int32_t key) const {
+        uint64_t id = sectionId(tag, key);
+        auto p = pending_.find(id);
+        if (p != pending_.end()) return {p->second.data(), p->second.size()};
+        auto it = index_.find(id);
+        if (it != index_.end()) return it->second;
+        return {nullptr, 0};
+    }
+
+    // Adds or replaces a section; written out by flush(), which this calls
+    // once the pending sections pass the cap. If that flush fails they are
+    // dropped rather than kept growing: they can be recomputed.
+    void put(uint32_t tag, int32_t key, const void* data, size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        std::vector<char>& section = pending_[sectionId(tag, key)];
+        pending_bytes_ = pending_bytes_ - section.size() + bytes;
+        section.assign(p, p + bytes);
+        if (pending_bytes_ > max_pending_bytes_ && !flush()) {
+            pending_.clear();
+            pending_bytes_ = 0;
+        }
+    }
+
+    bool dirty() const { return !pending_.empty(); }
+
+    // Writes the pending sections to the file and maps it again. False
+    // (and the old sections still readable) if it could not be written.
+    bool flush() {
+        if (pending_.empty()) return true;
+        size_t stale = stale_;
+        for (auto& [id, bytes] : pending_) {
+            auto it = index_.find(id);
+            if (it != index_.end()) stale += sizeof(Record) + padded(it->second.second);
+        }
+        if (!(data_ && stale <= size_ / 2 ? append() : rewrite())) return false;
+        pending_.clear();
+        pending_bytes_ = 0;
+        map();
+        return true;
+    }
+
+private:
+    static constexpr char kMagic[8] = {'M', 'A', 'P', 'F', 'C', 'A', 'C', 'H'};
+    static constexpr uint32_t kVersion = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t width, height;
+        uint32_t count;
+        uint64_t hash;
+    };
+    struct Record {
+        uint32_t tag;
+        int32_t key;
+        uint64_t bytes;
+    };
+    static_assert(sizeof(Header) == 32 && sizeof(Record) == 16, "on-disk layout");
+
+    std::string path_;
+    int width_, height_;
+    uint64_t hash_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    std::vector<char> buffer_;
+#endif
+    std::unordered_map<uint64_t, std::pair<const void*, size_t>> index_;  // into the mapping
+    uint32_t count_ = 0;  // sections in the file, replaced copies included
+    size_t end_ = 0;      // end of its last section
+    size_t stale_ = 0;    // bytes of replaced copies
+    std::unordered_map<uint64_t, std::vector<char>> pending_;
+    size_t pending_bytes_ = 0, max_pending_bytes_;
+
+    static uint64_t sectionId(uint32_t tag, int32_t key) {
+        return (uint64_t)tag << 32 | (uint32_t)key;
+    }
+    static size_t padded(size_t bytes) { return (bytes + 7) & ~(size_t)7; }
+
+    static void writeSection(std::ostream& out, uint64_t id, const void* payload, size_t bytes) {
+        Record r{(uint32_t)(id >> 32), (int32_t)(uint32_t)id, (uint64_t)bytes};
+        static const char zeros[8] = {};
+        out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        out.write(static_cast<const char*>(payload), (std::streamsize)bytes);
+        out.write(zeros, (std::streamsize)(padded(bytes) - bytes));
+    }
+
+    // Writes the pending sections after the last valid one (over any tail an
+    // interrupted append left), then the new count. Unmaps on success.
+    bool append() {
+        std::fstream out(path_, std::ios::binary | std::ios::in | std::ios::out);
+        if (!out) return false;
+        out.seekp((std::streamoff)end_);
+        for (auto& [id, bytes] : pending_) writeSection(out, id, bytes.data(), bytes.size());
+        if (!out.flush()) return false;
+        const uint32_t count = count_ + (uint32_t)pending_.size();
+        out.seekp((std::streamoff)offsetof(Header, count));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        if (!out.flush()) return false;
+        out.close();
+        unmap();
+        return true;
+    }
+
+    // Writes the live sections to a temporary file and renames it over the
+    // old one. Unmaps on success.
+    bool rewrite() {
+        std::string tmp = path_ + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            Header h{};
+            std::memcpy(h.magic, kMagic, sizeof(h.magic));
+            h.version = kVersion;
+            h.width = (uint32_t)width_;
+            h.height = (uint32_t)height_;
+            h.count = (uint32_t)sections();
+            h.hash = hash_;
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            for (auto& [id, s] : index_)
+                if (!pending_.count(id)) writeSection(out, id, s.first, s.second);
+            for (auto& [id, bytes] : pending_) writeSection(out, id, bytes.data(), bytes.size());
+            if (!out.flush()) {
+                out.close();
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        unmap();
+#if defined(_WIN32)
+        std::remove(path_.c_str());  // rename doesn't replace there
+#endif
+        if (std::rename(tmp.c_str(), path_.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            map();
+            return false;
+        }
+        return true;
+    }
+
+    void map() {
+#if defined(_WIN32)
+        std::ifstream in(path_, std::ios::binary);
+        if (!in) return;
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (buffer_.empty()) return;
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#else
+        int fd = ::open(path_.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const char*>(p);
+                size_ = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+        if (!data_) return;
+#endif
+        if (!buildIndex()) unmap();
+    }
+
+    void unmap() {
+        index_.clear();
+        count_ = 0;
+        end_ = stale_ = 0;
+#if defined(_WIN32)
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+#else
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // Checks the header against this grid and bounds-checks every section.
+    bool buildIndex() {
+        if (size_ < sizeof(Header)) return false;
+        Header h;
+        std::memcpy(&h, data_, sizeof(h));
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion
+            || h.width != (uint32_t)width_ || h.height != (uint32_t)height_ || h.hash != hash_)
+            return false;
+        size_t at = sizeof(Header);
+        for (uint32_t i = 0; i < h.count; i++) {
+            if (size_ - at < sizeof(Record)) return false;
+            Record r;
+            std::memcpy(&r, data_ + at, sizeof(r));
+            at += sizeof(Record);
+            if (r.bytes > size_ - at || padded(r.bytes) > size_ - at) return false;
+            auto& section = index_[sectionId(r.tag, r.key)];
+            if (section.first) stale_ += sizeof(Record) + padded(section.second);
+            section = {data_ + at, (size_t)r.bytes};
+            at += padded(r.bytes);
+        }
+        count_ = h.count;
+        end_ = at;
+        return true;
+    }
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "heuristic.h"
+#include <algorithm>
+
+/*
+ * Multi-valued decision diagram (MDD)
+ *
+ * All paths of one agent that reach its goal in exactly `cost` steps under a
+ * constraint table, as one level of cells per timestep: level t holds every
+ * cell some such path visits at t. Built forward (cells reachable at t that
+ * can still make the goal in time), then pruned backward (cells with no move
+ * into the next level). A level with a single cell is a singleton: every
+ * path of that cost passes through it at that time.
+ *
+ * Table is anything SpaceTimeAStar::findPath accepts.
+ */
+
+class MDD {
+public:
+    template <typename Table>
+    MDD(const Grid& grid, const Agent& agent, const Table& cons, int cost,
+        const HeuristicTable* heuristic = nullptr)
+    {
+        if (cost < 0 || cons.latestAt(grid.cellIndex(agent.goal)) >= cost) return;
+        auto hval = [&](Pos p) {
+            return heuristic ? (*heuristic)[grid.cellIndex(p)] : manhattan(p, agent.goal);
+        };
+        auto canMove = [&](Pos from, Pos to, int t) {
+            return !cons.blocked(grid.vertexKey(to, t)) && !cons.blocked(grid.edgeKey(from, to, t));
+        };
+        if (hval(agent.start) > cost) return;
+
+        levels_.assign(cost + 1, {});
+        levels_[0] = {grid.cellIndex(agent.start)};
+        for (int t = 0; t < cost; t++) {
+            auto& next = levels_[t + 1];
+            for (int cell : levels_[t]) {
+                Pos p = grid.cellPos(cell);
+                grid.forEachNeighbor(p, [&](Pos q) {
+                    if (hval(q) <= cost - t - 1 && canMove(p, q, t + 1))
+                        next.push_back(grid.cellIndex(q));
+                });
+            }
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            if (next.empty()) { levels_.clear(); return; }
+        }
+
+        int goal = grid.cellIndex(agent.goal);
+        if (!contains(goal, cost)) { levels_.clear(); return; }
+        levels_[cost] = {goal};
+        for (int t = cost - 1; t >= 0; t--) {
+            auto& level = levels_[t];
+            level.erase(std::remove_if(level.begin(), level.end(), [&](int cell) {
+                Pos p = grid.cellPos(cell);
+                bool alive = false;
+                grid.forEachNeighbor(p, [&](Pos q) {
+                    alive = alive || (contains(grid.cellIndex(q), t + 1) && canMove(p, q, t + 1));
+                });
+                return !alive;
+            }), level.end());
+        }
+    }
+
+    // False if no path of that cost exists.
+    bool valid() const { return !levels_.empty(); }
+    int cost() const { return (int)levels_.size() - 1; }
+
+    // Sorted cell indices at timestep t.
+    const std::vector<int>& level(int t) const { return levels_[t]; }
+
+    bool contains(int cell, int t) const {
+        if (t < 0 || t >= (int)levels_.size()) return false;
+        return std::binary_search(levels_[t].begin(), levels_[t].end(), cell);
+    }
+
+    bool singleton(int t) const { return levels_[t].size() == 1; }
+
+private:
+    std::vector<std::vector<int>> levels_;
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "low_level.h"
+#include "reservation_table.h"
+#include "heuristic.h"
+#include "conflicts.h"
+#include "solver.h"
+
+/*
+ * Priority-Based Search (PBS) — Ma et al., 2019
+ *
+ *   HIGH LEVEL: depth-first search over a Priority Tree (PT).
+ *     - Each PT node stores a partial priority order (pairs "i before j") and
+ *       a solution consistent with it: every agent avoids the paths of all
+ *       agents ranked above it.
+ *     - Root: no priorities, each agent on its own shortest path.
+ *     - Expand: take the first conflict (a1, a2) and branch on who goes
+ *       first. The child replans the lower agent, then every agent below it
+ *       (in topological order) that now collides with someone above it.
+ *     - The cheaper child is explored first; a node with no conflict is the
+ *       solution.
+ *
+ *   LOW LEVEL: Space-Time A* against a ReservationTable of the higher agents.
+ *
+ * Like prioritized planning it is incomplete and suboptimal, but it searches
+ * for an order instead of fixing one, and it scales far beyond CBS.
+ */
+
+struct PTNode {
+    std::vector<Path> paths;
+    std::vector<std::vector<int>> higher;  // higher[i]: agents directly above i
+    int cost;
+};
+
+class PBS : public MAPFSolver {
+public:
+    PBS(const Grid& grid, const std::vector<Agent>& agents)
+        : MAPFSolver(grid, agents), cache_(grid) {}
+
+    const char* name() const override { return "PBS"; }
+
+    // Back the goal distance tables with a persistent per-map cache.
+    void setMapCache(MapCache* store) { cache_.setStore(store); }
+
+    bool solve(int max_nodes = 100000) override {
+        begin();
+        const int n = (int)agents_.size();
+
+        heuristics_.clear();
+        for (auto& a : agents_) heuristics_.push_back(cache_.get(a.goal));
+
+        PTNode root;
+        root.paths.resize(n);
+        root.higher.resize(n);
+        for (auto& a : agents_) {
+            root.paths[a.id] = SpaceTimeAStar::findPath(grid_, a, ReservationTable(), -1,
+                                                        heuristics_[a.id].get(), stopFn());
+            if (root.paths[a.id].empty())
+                return finish(stopRequested() ? SolveStatus::CANCELLED : SolveStatus::NO_PATH);
+        }
+        root.cost = pathsCost(root.paths);
+        lower_bound_ = root.cost;  // each agent alone
+        nodes_generated_++;
+
+        std::vector<PTNode> stack;
+        stack.push_back(std::move(root));
+
+        while (!stack.empty() && nodes_expanded_ < max_nodes) {
+            if (stopRequested()) return finish(SolveStatus::CANCELLED);
+            PTNode curr = std::move(stack.back());
+            stack.pop_back();
+            nodes_expanded_++;
+            progress();
+
+            Conflict conflict;
+            if (!findFirstConflict(grid_, curr.paths, conflict)) {
+                solution_ = std::move(curr.paths);
+                solution_cost_ = curr.cost;
+                return finish(SolveStatus::SOLVED);
+            }
+
+            PTNode children[2];
+            bool ok[2] = {false, false};
+            for (int i = 0; i < 2; i++) {
+                int hi = i == 0 ? conflict.a1 : conflict.a2;
+                int lo = i == 0 ? conflict.a2 : conflict.a1;
+                if (above(curr, hi)[lo]) continue;  // would close a cycle
+                children[i].higher = curr.higher;
+                children[i].higher[lo].push_back(hi);
+                children[i].paths = curr.paths;
+                if (!replanBelow(children[i], lo)) {
+                    if (stopRequested()) return finish(SolveStatus::CANCELLED);
+                    continue;
+                }
+                children[i].cost = pathsCost(children[i].paths);
+                ok[i] = true;
+                nodes_generated_++;
+            }
+
+            // Push the cheaper child last so it is expanded next.
+            int first = (ok[0] && ok[1] && children[0].cost < children[1].cost) ? 1 : 0;
+            for (int i : {first, 1 - first})
+                if (ok[i]) stack.push_back(std::move(children[i]));
+        }
+        return finish(stack.empty() ? SolveStatus::NO_SOLUTION : SolveStatus::NODE_LIMIT);
+    }
+
+private:
+    HeuristicCache cache_;
+    std::vector<std::shared_ptr<const HeuristicTable>> heuristics_;
+
+    // mark[j] set for every agent ranked (transitively) above `agent`.
+    std::vector<char> above(const PTNode& node, int agent) const {
+        std::vector<char> mark(node.higher.size(), 0);
+        std::vector<int> todo = node.higher[agent];
+        while (!todo.empty()) {
+            int j = todo.back(); todo.pop_back();
+            if (mark[j]) continue;
+            mark[j] = 1;
+            for (int k : node.higher[j]) todo.push_back(k);
+        }
+        return mark;
+    }
+
+    // `agent` and everyone ranked below it, higher-ranked agents first.
+    std::vector<int> belowInOrder(const PTNode& node, int agent) const {
+        const int n = (int)node.higher.size();
+        std::vector<std::vector<int>> lower(n);
+        for (int i = 0; i < n; i++)
+            for (int j : node.higher[i]) lower[j].push_back(i);
+
+        std::vector<char> in(n, 0);
+        std::vector<int> todo = {agent};
+        while (!todo.empty()) {
+            int j = todo.back(); todo.pop_back();
+            if (in[j]) continue;
+            in[j] = 1;
+            for (int k : lower[j]) todo.push_back(k);
+        }
+
+        std::vector<int> indeg(n, 0), order = {agent};
+        for (int i = 0; i < n; i++)
+            if (in[i])
+                for (int j : node.higher[i]) indeg[i] += in[j];
+        for (size_t head = 0; head < order.size(); head++)
+            for (int k : lower[order[head]])
+                if (in[k] && --indeg[k] == 0) order.push_back(k);
+        return order;
+    }
+
+    bool replanBelow(PTNode& node, int agent) {
+        for (int i : belowInOrder(node, agent)) {
+            std::vector<char> mark = above(node, i);
+            bool collides = i == agent;
+            for (int j = 0; j < (int)mark.size() && !collides; j++)
+                collides = mark[j] && pathsConflict(node.paths[i], node.paths[j]);
+            if (!collides) continue;
+
+            ReservationTable reserved;
+            for (int j = 0; j < (int)mark.size(); j++)
+                if (mark[j]) reserved.reserve(grid_, node.paths[j]);
+            node.paths[i] = SpaceTimeAStar::findPath(grid_, agents_[i], reserved, -1,
+                                                     heuristics_[i].get(), stopFn());
+            if (node.paths[i].empty()) return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "low_level.h"
+#include "reservation_table.h"
+#include "heuristic.h"
+#include "hpa.h"
+#include "solver.h"
+#include <numeric>
+#include <random>
+
+/*
+ * Prioritized Planning (PP)
+ *
+ * Agents are planned one at a time in a total priority order. Each one runs
+ * Space-Time A* against a reservation table holding the paths of everyone
+ * planned before it, so the result is collision-free by construction. One
+ * low-level search per agent makes it fast enough for hundreds of agents, but
+ * it is neither complete nor optimal: a bad order can leave an agent with no
+ * path (e.g. its route is blocked by an earlier agent parked at its goal).
+ *
+ * solve(n) tries up to n orders: agent id order (or setPriorityOrder) first,
+ * then random restarts.
+ *
+ * With setHierarchy, the low level is guided by HierarchicalHeuristic (hpa.h)
+ * instead of a distance table per goal: on large maps that skips a BFS over
+ * the whole map and 4 bytes per cell for each agent, at the price of paths
+ * that may be a little longer. The reported lower bound is then the
+ * Manhattan sum.
+ */
+
+class PrioritizedPlanning : public MAPFSolver {
+public:
+    PrioritizedPlanning(const Grid& grid, const std::vector<Agent>& agents, unsigned seed = 0)
+        : MAPFSolver(grid, agents), cache_(grid), rng_(seed) {}
+
+    const char* name() const override { return "PP"; }
+
+    // Back the goal distance tables with a persistent per-map cache.
+    void setMapCache(MapCache* store) { cache_.setStore(store); }
+
+    // First order to try; order[0] has the highest priority.
+    void setPriorityOrder(std::vector<int> order) { order_ = std::move(order); }
+
+    // Plan against this abstraction of the grid instead of distance tables;
+    // must outlive the solver. nullptr goes back to tables.
+    void setHierarchy(const ClusterHierarchy* hierarchy) { hierarchy_ = hierarchy; }
+
+    bool solve(int max_nodes = 100000) override {
+        begin();
+
+        std::vector<std::shared_ptr<const HeuristicTable>> heuristics;
+        std::vector<std::unique_ptr<HierarchicalHeuristic>> estimates;
+        lower_bound_ = 0;
+        for (auto& a : agents_) {
+            int h;
+            if (hierarchy_) {
+                estimates.push_back(std::make_unique<HierarchicalHeuristic>(*hierarchy_, a.goal));
+                h = (*estimates.back())(a.start);
+                if (h < kUnreachable) h = manhattan(a.start, a.goal);
+            } else {
+                heuristics.push_back(cache_.get(a.goal));
+                h = (*heuristics.back())[grid_.cellIndex(a.start)];
+            }
+            if (h >= kUnreachable) return finish(SolveStatus::NO_PATH);
+            lower_bound_ += h;
+        }
+
+        std::vector<int> order = order_;
+        if (order.size() != agents_.size()) {
+            order.resize(agents_.size());
+            std::iota(order.begin(), order.end(), 0);
+        }
+
+        while (nodes_expanded_ < max_nodes) {
+            if (stopRequested()) return finish(SolveStatus::CANCELLED);
+            nodes_expanded_++;
+            progress();
+            std::vector<Path> paths(agents_.size());
+            ReservationTable reserved;
+            bool ok = true;
+            for (int id : order) {
+                nodes_generated_++;
+                if (hierarchy_)
+                    paths[id] = SpaceTimeAStar::findPathWith(grid_, agents_[id], reserved, -1,
+                                                             *estimates[id], stopFn());
+                else
+                    paths[id] = SpaceTimeAStar::findPath(grid_, agents_[id], reserved, -1,
+                                                         heuristics[id].get(), stopFn());
+                if (paths[id].empty()) {
+                    if (stopRequested()) return finish(SolveStatus::CANCELLED);
+                    ok = false;
+                    break;
+                }
+                reserved.reserve(grid_, paths[id]);
+            }
+            if (ok) {
+                solution_ = std::move(paths);
+                solution_cost_ = pathsCost(solution_);
+                return finish(SolveStatus::SOLVED);
+            }
+            std::shuffle(order.begin(), order.end(), rng_);
+        }
+        return finish(SolveStatus::NODE_LIMIT);
+    }
+
+private:
+    HeuristicCache cache_;
+    const ClusterHierarchy* hierarchy_ = nullptr;
+    std::mt19937 rng_;
+    std::vector<int> order_;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+ * Space-time reservation table
+ *
+ * The paths of already planned (higher-priority) agents, as seen by the next
+ * one: every (cell, t) they occupy, the reverse of every move they make (so
+ * the next agent can't swap with them), and their goal cells from arrival
+ * onward, since agents stay at their goals.
+ *
+ * Exposes the same queries as ConstraintTable, so SpaceTimeAStar::findPath
+ * plans against either, or against both through TableUnion.
+ */
+
+class ReservationTable {
+public:
+    void reserve(const Grid& grid, const Path& path) {
+        if (path.empty()) return;
+        int end = (int)path.size() - 1;
+        for (int t = 0; t <= end; t++) {
+            vertices_.insert(grid.vertexKey(path[t], t));
+            int& at = latest_at_.try_emplace(grid.cellIndex(path[t]), -1).first->second;
+            at = std::max(at, t);
+            if (t > 0 && !(path[t] == path[t - 1]))
+                edges_.insert(grid.edgeKey(path[t], path[t - 1], t));
+        }
+        int goal = grid.cellIndex(path[end]);
+        auto [it, fresh] = parked_.try_emplace(goal, end);
+        if (!fresh) it->second = std::min(it->second, end);
+        latest_at_[goal] = INT_MAX;
+        latest_ = std::max(latest_, end);
+    }
+
+    // key is Grid::vertexKey or Grid::edgeKey at the arrival timestep.
+    bool blocked(StateKey key) const {
+        if (keyMove(key) != MOVE_NONE)
+            return keyTime(key) <= latest_ && edges_.count(key);
+        auto it = parked_.find(keyCell(key));
+        if (it != parked_.end() && keyTime(key) >= it->second) return true;
+        return keyTime(key) <= latest_ && vertices_.count(key);
+    }
+
+    // After this timestep only parked agents remain, and they never move.
+    int latestTimestep() const { return latest_; }
+
+    // Last timestep the cell is reserved; INT_MAX if an agent parks there.
+    int latestAt(int cell) const {
+        auto it = latest_at_.find(cell);
+        return it == latest_at_.end() ? -1 : it->second;
+    }
+
+private:
+    std::unordered_set<StateKey, KeyHash> vertices_;
+    std::unordered_set<StateKey, KeyHash> edges_;
+    std::unordered_map<int, int> parked_;     // cell -> arrival timestep
+    std::unordered_map<int, int> latest_at_;
+    int latest_ = -1;
+};
+
+// Blocks whatever either table blocks, e.g. a CBS agent's constraints plus
+// the reservations of agents outside the CBS instance.
+template <typename A, typename B>
+class TableUnion {
+public:
+    TableUnion(const A& a, const B& b) : a_(a), b_(b) {}
+
+    bool blocked(StateKey key) const { return a_.blocked(key) || b_.blocked(key); }
+    int latestTimestep() const { return std::max(a_.latestTimestep(), b_.latestTimestep()); }
+    int latestAt(int cell) const { return std::max(a_.latestAt(cell), b_.latestAt(cell)); }
+
+private:
+    const A& a_;
+    const B& b_;
+};
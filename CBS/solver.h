@@ -0,0 +1,151 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include <atomic>
+#include <functional>
+
+/*
+ * MAPF solver interface
+ *
+ * Common base for the planners in this directory (CBS, PBS, prioritized
+ * planning), so drivers like the stress test can run them side by side.
+ * A solver is built for one instance and reports its search effort in its
+ * own units: CT nodes for CBS, priority tree nodes for PBS, priority orders
+ * tried for prioritized planning.
+ *
+ * Solvers never print. How a solve() ended is in getStatus(), and a caller
+ * on another thread can follow it with a progress callback and stop it with
+ * cancel() (see async_solve.h).
+ */
+
+enum class SolveStatus {
+    NOT_STARTED,
+    SOLVED,
+    SOLVED_SUBOPTIMAL,  // CBS with MemoryPolicy::DROP_WORST: a solution, but a
+                        // dropped node might have led to a cheaper one;
+                        // getLowerBound() bounds the optimum
+    NO_PATH,       // some agent can't reach its goal even alone
+    NO_SOLUTION,   // search space exhausted; for optimal CBS, no solution exists
+    NODE_LIMIT,    // gave up after max_nodes
+    MEMORY_LIMIT,  // CBS memory budget: hit with MemoryPolicy::STOP, or OPEN ran
+                   // out after DROP_WORST discarded nodes
+    CANCELLED,
+};
+
+inline bool isSolved(SolveStatus status) {
+    return status == SolveStatus::SOLVED || status == SolveStatus::SOLVED_SUBOPTIMAL;
+}
+
+struct SolveProgress {
+    int nodes_expanded;
+    int nodes_generated;
+    int lower_bound;     // on the optimal sum of costs; -1 if the solver has none
+    int incumbent_cost;  // best solution so far; mid-solve only from anytime
+                         // solvers (LNSSolver), else -1 until the final report
+};
+
+using ProgressCallback = std::function<void(const SolveProgress&)>;
+
+class MAPFSolver {
+public:
+    virtual ~MAPFSolver() = default;
+
+    virtual const char* name() const = 0;
+
+    // Returns true and stores a collision-free solution, or gives up after
+    // max_nodes units of search.
+    virtual bool solve(int max_nodes = 100000) = 0;
+
+    const std::vector<Path>& getSolution() const { return solution_; }
+    int getSolutionCost() const { return solution_cost_; }
+    int getNodesExpanded() const { return nodes_expanded_; }
+    int getNodesGenerated() const { return nodes_generated_; }
+    SolveStatus getStatus() const { return status_; }
+    int getLowerBound() const { return lower_bound_; }
+
+    // Called on the solving thread every `every` units of search and once
+    // when solve() returns.
+    void setProgressCallback(ProgressCallback callback, int every = 1000) {
+        on_progress_ = std::move(callback);
+        progress_every_ = std::max(every, 1);
+    }
+
+    // Safe from any thread: a running or later solve() returns false soon,
+    // with status CANCELLED. Stays set. An anytime solver that already holds
+    // a solution stops improving it and returns it as SOLVED instead.
+    void cancel() { cancelled_ = true; }
+
+    // Cancelling `parent` cancels this solver too; for solvers run as part
+    // of another one, e.g. the per-group CBS of Independence Detection.
+    void setParent(const MAPFSolver* parent) { parent_ = parent; }
+
+    // Stop as on cancel() once `check` returns true; for solvers run by
+    // something that isn't a MAPFSolver, e.g. AnytimeLNS's CBS replanner.
+    void setStopCheck(StopFn check) { stop_check_ = std::move(check); }
+
+protected:
+    MAPFSolver(const Grid& grid, const std::vector<Agent>& agents)
+        : grid_(grid), agents_(agents) {}
+
+    bool stopRequested() const {
+        return cancelled_ || (parent_ && parent_->stopRequested()) || (stop_check_ && stop_check_());
+    }
+
+    // stopRequested() for the low-level searches, so a cancel() doesn't wait
+    // for a long one to finish.
+    StopFn stopFn() const { return [this] { return stopRequested(); }; }
+
+    // Resets the per-solve state; call first in solve().
+    void begin() {
+        nodes_expanded_ = 0;
+        nodes_generated_ = 0;
+        lower_bound_ = -1;
+        incumbent_cost_ = -1;
+        last_report_ = 0;
+        status_ = SolveStatus::NOT_STARTED;
+    }
+
+    // Reports progress if `every` more nodes were expanded since last time.
+    void progress() {
+        if (on_progress_ && nodes_expanded_ - last_report_ >= progress_every_) report();
+    }
+
+    // Records the outcome, sends a final report and returns solve()'s result.
+    bool finish(SolveStatus status) {
+        status_ = status;
+        if (!isSolved(status)) solution_cost_ = -1;
+        if (on_progress_) report();
+        return isSolved(status);
+    }
+
+    // Sum of costs; every path ends at its agent's goal.
+    static int pathsCost(const std::vector<Path>& paths) {
+        int cost = 0;
+        for (auto& p : paths) cost += (int)p.size() - 1;
+        return cost;
+    }
+
+    const Grid& grid_;
+    const std::vector<Agent>& agents_;
+    std::vector<Path> solution_;
+    int solution_cost_ = -1;
+    int nodes_expanded_ = 0;
+    int nodes_generated_ = 0;
+    int lower_bound_ = -1;  // reported with progress; kept up to date by the solver
+    int incumbent_cost_ = -1;  // likewise, by anytime solvers
+
+private:
+    SolveStatus status_ = SolveStatus::NOT_STARTED;
+    std::atomic<bool> cancelled_{false};
+    const MAPFSolver* parent_ = nullptr;
+    StopFn stop_check_;
+    ProgressCallback on_progress_;
+    int progress_every_ = 1000;
+    int last_report_ = 0;
+
+    void report() {
+        last_report_ = nodes_expanded_;
+        on_progress_({nodes_expanded_, nodes_generated_, lower_bound_,
+                      isSolved(status_) ? solution_cost_ : incumbent_cost_});
+    }
+};
@@ -1,15 +1,26 @@
+#include "bitgrid.h"
 #include "cbs.h"
+#include "independence.h"
+#include "pbs.h"
+#include "prioritized.h"
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <random>
 #include <iomanip>
 
 /*
- * CBS Stress Test — Success Rate vs Number of Agents
+ * MAPF Stress Test — Success Rate vs Number of Agents
  *
- * Replicates the style of experiments from Sharon et al. (2015).
+ * Replicates the style of experiments from Sharon et al. (2015). Every
+ * solver (CBS, ID+CBS, PBS, prioritized planning) runs on the same instances.
+ * Goal distance tables persist across runs in stress_test.mapcache.
  */
 
-bool generateInstance(const Grid& grid, int k, std::vector<Agent>& agents, std::mt19937& rng) {
+// Random distinct starts and goals, redrawn until every goal is in its
+// start's connected component.
+bool generateInstance(const Grid& grid, const Components& components, int k,
+                      std::vector<Agent>& agents, std::mt19937& rng) {
     std::vector<Pos> free_cells;
     for (int y = 0; y < grid.height; y++)
         for (int x = 0; x < grid.width; x++)
@@ -18,12 +29,15 @@ bool generateInstance(const Grid& grid, int k, std::vector<Agent>& agents, std::
 
     if ((int)free_cells.size() < 2 * k) return false;
 
-    std::shuffle(free_cells.begin(), free_cells.end(), rng);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        std::shuffle(free_cells.begin(), free_cells.end(), rng);
 
-    agents.clear();
-    for (int i = 0; i < k; i++)
-        agents.push_back({i, free_cells[i], free_cells[k + i]});
-    return true;
+        agents.clear();
+        for (int i = 0; i < k; i++)
+            agents.push_back({i, free_cells[i], free_cells[k + i]});
+        if (firstInvalidAgent(grid, components, agents) < 0) return true;
+    }
+    return false;
 }
 
 int main() {
@@ -45,18 +59,47 @@ int main() {
                     grid.setObstacle(x, y);
     }
 
+    MapCache map_cache(grid, "stress_test.mapcache");
+    Components components = cachedComponents(grid, map_cache);
+    HeuristicCache heuristics(grid);
+    heuristics.setStore(&map_cache);
+
+    using SolverFactory = std::function<std::unique_ptr<MAPFSolver>(const Grid&, const std::vector<Agent>&)>;
+    const std::vector<SolverFactory> SOLVERS = {
+        [&](const Grid& g, const std::vector<Agent>& a) {
+            auto s = std::make_unique<CBS>(g, a);
+            s->setHeuristicCache(&heuristics);
+            return s;
+        },
+        [](const Grid& g, const std::vector<Agent>& a) { return std::make_unique<IndependenceDetection>(g, a); },
+        [&](const Grid& g, const std::vector<Agent>& a) {
+            auto s = std::make_unique<PBS>(g, a);
+            s->setMapCache(&map_cache);
+            return s;
+        },
+        [&](const Grid& g, const std::vector<Agent>& a) {
+            auto s = std::make_unique<PrioritizedPlanning>(g, a);
+            s->setMapCache(&map_cache);
+            return s;
+        },
+    };
+    const int S = (int)SOLVERS.size();
+
     int free_count = 0;
     for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++)
         if (!grid.obstacles[i]) free_count++;
 
-    std::cout << "CBS Stress Test — Success Rate vs Agent Count\n";
+    std::cout << "MAPF Stress Test — Success Rate vs Agent Count\n";
     std::cout << "Grid: " << GRID_SIZE << "x" << GRID_SIZE
               << " | Free: " << free_count
               << " | Instances/k: " << INSTANCES
               << " | Node limit: " << NODE_LIMIT
-              << " | Time limit: " << TIME_LIMIT << "s\n";
+              << " | Time limit: " << TIME_LIMIT << "s"
+              << " | Map cache: " << map_cache.sections() << " sections"
+              << (map_cache.loaded() ? " (loaded)" : " (new)") << "\n";
     std::cout << std::string(76, '=') << "\n";
     std::cout << std::setw(4) << "k"
+              << std::setw(6) << "algo"
               << std::setw(10) << "solved"
               << std::setw(10) << "rate%"
               << std::setw(12) << "avg_ms"
@@ -65,73 +108,87 @@ int main() {
               << std::setw(10) << "avg_cost" << "\n";
     std::cout << std::string(76, '-') << "\n";
 
-    std::vector<std::pair<int,double>> chart_data;
+    std::vector<std::vector<std::pair<int,double>>> chart_data(S);
+    std::vector<const char*> names(S);
 
     for (int k = K_MIN; k <= K_MAX; k++) {
-        int solved = 0;
-        double total_time = 0, total_exp = 0, total_gen = 0, total_cost = 0;
+        std::vector<int> solved(S, 0);
+        std::vector<double> total_time(S, 0), total_exp(S, 0), total_gen(S, 0), total_cost(S, 0);
 
         for (int inst = 0; inst < INSTANCES; inst++) {
             std::vector<Agent> agents;
-            if (!generateInstance(grid, k, agents, rng))
+            if (!generateInstance(grid, components, k, agents, rng))
                 continue;
 
-            CBS cbs(grid, agents);
+            for (int s = 0; s < S; s++) {
+                auto solver = SOLVERS[s](grid, agents);
+                names[s] = solver->name();
 
-            auto t0 = std::chrono::high_resolution_clock::now();
-            bool ok = cbs.solve(NODE_LIMIT);
-            auto t1 = std::chrono::high_resolution_clock::now();
-            double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+                auto t0 = std::chrono::high_resolution_clock::now();
+                bool ok = solver->solve(NODE_LIMIT);
+                auto t1 = std::chrono::high_resolution_clock::now();
+                double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
 
-            if (ms > TIME_LIMIT * 1000) ok = false;
+                if (ms > TIME_LIMIT * 1000) ok = false;
 
-            if (ok) {
-                solved++;
-                total_time += ms;
-                total_exp += cbs.getNodesExpanded();
-                total_gen += cbs.getNodesGenerated();
-                total_cost += cbs.getSolutionCost();
+                if (ok) {
+                    solved[s]++;
+                    total_time[s] += ms;
+                    total_exp[s] += solver->getNodesExpanded();
+                    total_gen[s] += solver->getNodesGenerated();
+                    total_cost[s] += solver->getSolutionCost();
+                }
             }
         }
 
-        double rate = 100.0 * solved / INSTANCES;
-        double avg_ms  = solved > 0 ? total_time / solved : 0;
-        double avg_exp = solved > 0 ? total_exp / solved : 0;
-        double avg_gen = solved > 0 ? total_gen / solved : 0;
-        double avg_cost = solved > 0 ? total_cost / solved : 0;
-
-        chart_data.push_back({k, rate});
-
-        std::cout << std::setw(4) << k
-                  << std::setw(7) << solved << "/" << std::setw(2) << INSTANCES
-                  << std::setw(9) << std::fixed << std::setprecision(0) << rate << "%"
-                  << std::setw(12) << std::setprecision(1) << avg_ms
-                  << std::setw(12) << std::setprecision(0) << avg_exp
-                  << std::setw(12) << avg_gen
-                  << std::setw(10) << std::setprecision(1) << avg_cost << "\n";
+        bool any = false;
+        for (int s = 0; s < S; s++) {
+            double rate = 100.0 * solved[s] / INSTANCES;
+            double avg_ms  = solved[s] > 0 ? total_time[s] / solved[s] : 0;
+            double avg_exp = solved[s] > 0 ? total_exp[s] / solved[s] : 0;
+            double avg_gen = solved[s] > 0 ? total_gen[s] / solved[s] : 0;
+            double avg_cost = solved[s] > 0 ? total_cost[s] / solved[s] : 0;
+
+            chart_data[s].push_back({k, rate});
+            any = any || solved[s] > 0;
+
+            std::cout << std::setw(4) << k
+                      << std::setw(6) << names[s]
+                      << std::setw(7) << solved[s] << "/" << std::setw(2) << INSTANCES
+                      << std::setw(9) << std::fixed << std::setprecision(0) << rate << "%"
+                      << std::setw(12) << std::setprecision(1) << avg_ms
+                      << std::setw(12) << std::setprecision(0) << avg_exp
+                      << std::setw(12) << avg_gen
+                      << std::setw(10) << std::setprecision(1) << avg_cost << "\n";
+        }
 
-        if (solved == 0 && k > K_MIN + 2) {
+        if (!any && k > K_MIN + 2) {
             std::cout << "[Stopped: 0% success rate]\n";
             for (int kk = k + 1; kk <= K_MAX; kk++)
-                chart_data.push_back({kk, 0});
+                for (auto& data : chart_data) data.push_back({kk, 0});
             break;
         }
     }
 
-    std::cout << "\n" << std::string(76, '=') << "\n";
-    std::cout << "Success Rate vs k  (each block = 2%)\n";
-    std::cout << std::string(76, '-') << "\n";
+    for (int s = 0; s < S; s++) {
+        std::cout << "\n" << std::string(76, '=') << "\n";
+        std::cout << names[s] << ": Success Rate vs k  (each block = 2%)\n";
+        std::cout << std::string(76, '-') << "\n";
+
+        for (auto& [k, rate] : chart_data[s]) {
+            int bars = (int)(rate / 2.0 + 0.5);
+            std::cout << "k=" << std::setw(2) << k << " |";
+            for (int i = 0; i < bars; i++) std::cout << "#";
+            for (int i = bars; i < 50; i++) std::cout << " ";
+            std::cout << "| " << std::setw(3) << (int)rate << "%\n";
+        }
 
-    for (auto& [k, rate] : chart_data) {
-        int bars = (int)(rate / 2.0 + 0.5);
-        std::cout << "k=" << std::setw(2) << k << " |";
-        for (int i = 0; i < bars; i++) std::cout << "#";
-        for (int i = bars; i < 50; i++) std::cout << " ";
-        std::cout << "| " << std::setw(3) << (int)rate << "%\n";
+        std::cout << "      " << std::string(50, '-') << "\n";
+        std::cout << "      0%       20%       40%       60%       80%      100%\n";
     }
 
-    std::cout << "      " << std::string(50, '-') << "\n";
-    std::cout << "      0%       20%       40%       60%       80%      100%\n";
+    if (!map_cache.flush())
+        std::cerr << "Could not write stress_test.mapcache\n";
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,233 @@
+#pragma once
+#include "common.h"
+#include "grid.h"
+#include "heuristic.h"
+#include "mdd.h"
+#include <array>
+
+/*
+ * Symmetry reasoning for CBS (after Li et al., 2019/2020)
+ *
+ * Some conflicts have an exponential number of equally good resolutions, and
+ * standard CBS branches on every one of them before the cost goes up. The
+ * two patterns below are recognized and settled by one split whose branches
+ * each rule out a whole family of resolutions.
+ *
+ * Rectangle: two agents reach a vertex conflict on time along Manhattan-
+ * optimal paths from their starts, moving the same way on both axes, so
+ * every pair of shortest routes through the rectangle between the starts
+ * (corner Rs) and where their MDDs stop being forced (corner Rg) collides
+ * somewhere in it. One branch puts a barrier across a1's exit side of the
+ * rectangle (a1 may not be on time at any of its cells), the other across
+ * a2's. Barriers are anchored at the starts, where the agents are known to
+ * be, and keep only cells in the agents' MDDs.
+ *
+ * Corridor: the agents cross in opposite directions in a chain of k degree-2
+ * cells between endpoints e1 and e2 (so k + 1 moves apart). One of them goes
+ * through first, so either a1 doesn't reach e2 before a2 could have crossed
+ * or gone around, or the reverse. These are range constraints:
+ *   a1 not at e2 during [0, min(t1'(e2) - 1, lb2(e1) + k)]
+ *   a2 not at e1 during [0, min(t2'(e1) - 1, lb1(e2) + k)]
+ * where lb is the BFS distance from the start and t' the BFS distance with
+ * the corridor blocked. a2 can't be through before lb2(e1) + k + 1, so the
+ * range stops one step short of what the crossing time allows; that keeps
+ * it sound.
+ *
+ * Both only return branches that rule out the current paths; otherwise the
+ * caller falls back to the standard vertex/edge split.
+ */
+
+// The constraints added by each child of a conflict; each child's are all
+// on one agent.
+using ConflictBranches = std::array<std::vector<Constraint>, 2>;
+
+inline ConflictBranches standardBranches(const Conflict& conflict) {
+    ConflictBranches out;
+    for (int i = 0; i < 2; i++) {
+        Constraint c;
+        c.agent = i == 0 ? conflict.a1 : conflict.a2;
+        c.timestep = conflict.timestep;
+        c.is_edge = conflict.is_edge;
+        if (!conflict.is_edge) {
+            c.loc = conflict.loc;
+            c.loc2 = {-1, -1};
+        } else {
+            c.loc = i == 0 ? conflict.loc : conflict.loc2;
+            c.loc2 = i == 0 ? conflict.loc2 : conflict.loc;
+        }
+        out[i] = {c};
+    }
+    return out;
+}
+
+// True if the path (agent parked at its goal after the end) breaks any of cs.
+inline bool violates(const Path& path, const std::vector<Constraint>& cs) {
+    auto at = [&](int t) { return t < (int)path.size() ? path[t] : path.back(); };
+    for (auto& c : cs) {
+        if (c.is_edge) {
+            if (c.timestep > 0 && at(c.timestep - 1) == c.loc && at(c.timestep) == c.loc2) return true;
+            continue;
+        }
+        for (int t = c.timestep; t <= std::max(c.timestep, c.until); t++)
+            if (at(t) == c.loc) return true;
+    }
+    return false;
+}
+
+// BFS distance from `from` to `to` over free cells not marked in `avoid`
+// (may be empty); kUnreachable if there is none.
+inline int bfsDistance(const Grid& grid, Pos from, Pos to, const std::vector<char>& avoid = {}) {
+    if (from == to) return 0;
+    std::vector<int> dist((size_t)grid.width * grid.height, -1);
+    std::vector<int> queue = {grid.cellIndex(from)};
+    dist[queue[0]] = 0;
+    const int target = grid.cellIndex(to);
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        int found = -1;
+        grid.forEachNeighbor(grid.cellPos(cell), [&](Pos q) {
+            int n = grid.cellIndex(q);
+            if (dist[n] >= 0 || (!avoid.empty() && avoid[n])) return;
+            dist[n] = dist[cell] + 1;
+            if (n == target) found = dist[n];
+            queue.push_back(n);
+        });
+        if (found >= 0) return found;
+    }
+    return kUnreachable;
+}
+
+// mdd1/mdd2: MDDs of a1 and a2 at the cost of their current paths.
+inline bool rectangleBranches(const Grid& grid, const std::vector<Agent>& agents,
+                              const std::vector<Path>& paths, const Conflict& conflict,
+                              const MDD& mdd1, const MDD& mdd2, ConflictBranches& out) {
+    if (conflict.is_edge) return false;
+    const Pos v = conflict.loc;
+    const int t = conflict.timestep;
+    const int ids[2] = {conflict.a1, conflict.a2};
+    const MDD* mdds[2] = {&mdd1, &mdd2};
+    Pos s[2];
+    for (int i = 0; i < 2; i++) {
+        s[i] = agents[ids[i]].start;
+        if (manhattan(s[i], v) != t || !mdds[i]->valid() || t > mdds[i]->cost()) return false;
+    }
+    auto sign = [](int d) { return (d > 0) - (d < 0); };
+    if (sign(v.x - s[0].x) * sign(v.x - s[1].x) < 0) return false;  // head-on in x
+    if (sign(v.y - s[0].y) * sign(v.y - s[1].y) < 0) return false;
+
+    // Direction of travel; an axis neither agent has moved on yet is taken
+    // from the first MDD step away from v, defaulting to +1.
+    int sx = sign(v.x - s[0].x) ? sign(v.x - s[0].x) : sign(v.x - s[1].x);
+    int sy = sign(v.y - s[0].y) ? sign(v.y - s[0].y) : sign(v.y - s[1].y);
+
+    // Far corner: the last MDD singletons still on a Manhattan-optimal
+    // continuation from v in the direction of travel.
+    Pos g[2];
+    for (int i = 0; i < 2; i++) {
+        g[i] = v;
+        for (int tau = t + 1; tau <= mdds[i]->cost(); tau++) {
+            if (!mdds[i]->singleton(tau)) continue;
+            Pos p = grid.cellPos(mdds[i]->level(tau)[0]);
+            if (manhattan(v, p) != tau - t) break;
+            if (!sx) sx = sign(p.x - v.x);
+            if (!sy) sy = sign(p.y - v.y);
+            if ((sx && sign(p.x - v.x) == -sx) || (sy && sign(p.y - v.y) == -sy)) break;
+            g[i] = p;
+        }
+    }
+    if (!sx) sx = 1;
+    if (!sy) sy = 1;
+
+    // Normalized so both agents move toward +u and +v.
+    auto lo = [](int a, int b, int dir) { return dir > 0 ? std::max(a, b) : std::min(a, b); };
+    auto hi = [](int a, int b, int dir) { return dir > 0 ? std::min(a, b) : std::max(a, b); };
+    Pos rs = {lo(s[0].x, s[1].x, sx), lo(s[0].y, s[1].y, sy)};
+    Pos rg = {hi(g[0].x, g[1].x, sx), hi(g[0].y, g[1].y, sy)};
+    if (rs == rg) return false;
+
+    // Both starts lie on one antidiagonal; the agent further back in x
+    // leaves across the far x side, the other across the far y side.
+    int x_side = sx * (s[0].x - s[1].x) <= 0 ? 0 : 1;
+    for (int i = 0; i < 2; i++) {
+        bool across_x = i == x_side;
+        Pos from = across_x ? Pos{rg.x, rs.y} : Pos{rs.x, rg.y};
+        Pos step = across_x ? Pos{0, sy} : Pos{sx, 0};
+        out[i].clear();
+        for (Pos p = from;; p = {p.x + step.x, p.y + step.y}) {
+            int at = manhattan(s[i], p);
+            if (mdds[i]->contains(grid.cellIndex(p), at)) {
+                Constraint c;
+                c.agent = ids[i];
+                c.loc = p;
+                c.loc2 = {-1, -1};
+                c.timestep = at;
+                c.is_edge = false;
+                out[i].push_back(c);
+            }
+            if (p == rg) break;
+        }
+        if (!violates(paths[ids[i]], out[i])) return false;
+    }
+    return true;
+}
+
+inline bool corridorBranches(const Grid& grid, const std::vector<Agent>& agents,
+                             const std::vector<Path>& paths, const Conflict& conflict,
+                             ConflictBranches& out) {
+    Pos c = grid.degree(conflict.loc) == 2 ? conflict.loc : conflict.loc2;
+    if (!conflict.is_edge) c = conflict.loc;
+    if (grid.degree(c) != 2) return false;
+
+    // Walk the chain of degree-2 cells both ways from c; k counts them.
+    std::vector<char> interior((size_t)grid.width * grid.height, 0);
+    interior[grid.cellIndex(c)] = 1;
+    int k = 1;
+    Pos ends[2];
+    int side = 0;
+    grid.forEachNeighbor(c, [&](Pos first) {
+        if (first == c || side > 1) return;
+        Pos prev = c, at = first;
+        while (grid.degree(at) == 2 && !(at == c)) {
+            interior[grid.cellIndex(at)] = 1;
+            k++;
+            Pos next = at;
+            grid.forEachNeighbor(at, [&](Pos q) {
+                if (!(q == at) && !(q == prev)) next = q;
+            });
+            prev = at;
+            at = next;
+        }
+        ends[side++] = at;
+    });
+    if (side != 2 || ends[0] == c || ends[1] == c || ends[0] == ends[1]) return false;
+
+    const int ids[2] = {conflict.a1, conflict.a2};
+    auto inside = [&](Pos p) { return (bool)interior[grid.cellIndex(p)]; };
+    for (int flip = 0; flip < 2; flip++) {
+        // a1 enters at e[0] and leaves at e[1]; a2 the other way.
+        Pos e[2] = {ends[flip], ends[1 - flip]};
+        Pos s[2] = {agents[ids[0]].start, agents[ids[1]].start};
+        bool ok = true;
+        for (int i = 0; i < 2; i++)
+            ok = ok && !inside(s[i]) && !(s[i] == e[1 - i]);
+        if (!ok) continue;
+
+        int lb[2], around[2];
+        for (int i = 0; i < 2; i++) {
+            lb[i] = bfsDistance(grid, s[i], e[1 - i]);
+            around[i] = bfsDistance(grid, s[i], e[1 - i], interior);
+        }
+        for (int i = 0; i < 2; i++) {
+            Constraint r;
+            r.agent = ids[i];
+            r.loc = e[1 - i];
+            r.loc2 = {-1, -1};
+            r.timestep = 0;
+            r.until = (int)std::min<long long>((long long)around[i] - 1, (long long)lb[1 - i] + k);
+            r.is_edge = false;
+            out[i] = {r};
+        }
+        if (violates(paths[ids[0]], out[0]) && violates(paths[ids[1]], out[1])) return true;
+    }
+    return false;
+}